@@ -4,6 +4,120 @@
 #include <obs-module.h>
 #include "ort-model/ONNXRuntimeModel.h"
 #include "sort/Sort.h"
+#include "motion-gate.h"
+#include "FramePool.h"
+#include "TripleBuffer.h"
+#include "PreviewOverlay.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+  * @brief Performance counters of the detection worker
+  *
+  * Counters are reset every time they are logged, so they describe the last logging interval.
+*/
+struct detect_stats {
+	std::atomic<uint64_t> framesSubmitted{0};
+	std::atomic<uint64_t> framesDropped{0};
+	std::atomic<uint64_t> framesProcessed{0};
+	std::atomic<uint64_t> framesSkipped{0}; // by the inference rate limit
+	std::atomic<uint64_t> gateSkipped{0}; // by the motion gate
+	std::atomic<uint64_t> inferenceRuns{0};
+	std::atomic<uint64_t> inferenceTotalUs{0};
+	std::atomic<uint64_t> workerLatencyTotalUs{0};
+	std::atomic<uint64_t> workerLatencyMaxUs{0};
+	// textures, texrender targets, stage surfaces and vertex buffers allocated on the GPU
+	std::atomic<uint64_t> gpuAllocations{0};
+};
+
+/**
+  * @brief A model to build on the background loader
+  *
+  * Holds everything needed to construct the model, so the loader never reads the filter
+  * settings while they are being updated.
+*/
+struct model_load_request {
+	uint64_t generation;
+	file_name_t modelFilepath;
+	std::string modelSize;
+	std::string useGPU;
+	uint32_t numThreads;
+	int numClasses;
+	std::vector<std::string> classNames;
+};
+
+/**
+  * @brief The class names and the input size of a loaded model
+  *
+  * Never modified once the loader created it. The worker hands it on with the results it
+  * detected with the model, so the graphics thread does not read state the loader replaces.
+*/
+struct model_info {
+	std::vector<std::string> classNames;
+	cv::Size inputSize;
+};
+
+/**
+  * @brief The filter settings that the model applies while decoding
+  *
+  * The settings update hands a copy to the detection worker, which applies it before its next
+  * model run, so the update never waits for a model run to finish.
+*/
+struct model_config {
+	float bboxConfThreshold = 0.5f; // lower than the threshold for ByteTrack
+	int batchMaxSize = 1;
+	int batchMaxWait = 0; // ms
+	std::string nmsMode;
+	int objectCategory = -1;
+	std::vector<std::string> objectCategoryNames;
+	float minArea = 0.0f;
+	float maxArea = 0.0f; // 0 for no limit
+	size_t topK = 0; // 0 for no limit
+};
+
+// stage surfaces in the GPU readback ring, the readback latency is at most one less
+const int STAGE_SURFACE_COUNT = 3;
+
+// levels of the masking blur pyramid, each half the size of the previous one
+const int BLUR_PYRAMID_LEVELS = 5;
+
+/**
+  * @brief A stage surface of the GPU readback ring and the frame staged in it
+*/
+struct stage_slot {
+	gs_stagesurf_t *surface;
+	bool pending; // staged and not mapped yet
+	cv::Rect region; // region of the source frame in the surface
+	cv::Size sourceSize;
+};
+
+/**
+  * @brief A captured frame, handed from the render thread to the detection worker
+  *
+  * The image holds the region of a source frame of sourceSize, scaled to the image size.
+*/
+struct captured_frame {
+	cv::Mat imageBGRA;
+	cv::Rect region;
+	cv::Size sourceSize;
+	std::chrono::steady_clock::time_point timestamp;
+};
+
+/**
+  * @brief Results of the detection worker for the video tick and render
+*/
+struct detect_output {
+	std::vector<Object> objects;
+	cv::Size frameSize; // size of the source frame the objects are in
+	int detectedLabel = -1;
+	// the model that detected the objects, for their class names and the readback size
+	std::shared_ptr<const model_info> model;
+};
 
 /**
   * @brief The filter_data struct
@@ -18,12 +132,25 @@ struct filter_data {
 	std::string modelSize;
 
 	int minAreaThreshold;
+	int maxAreaThreshold; // 0 for no limit
+	int maxDetections; // 0 for no limit
+	bool tiledInference;
+	float tileOverlap;
+	bool tileFullFrame;
+	bool motionGating;
+	float motionThreshold; // percentage of changed blocks
+	int motionMaxSkip;
+	int maxInferenceFps; // 0 for no limit
+	int inferenceBudget; // percentage of time the model may run, 0 for no limit
 	int objectCategory;
+	std::vector<std::string> objectCategoryNames; // more categories, by class name
 	bool maskingEnabled;
 	std::string maskingType;
 	int maskingColor;
 	int maskingBlurRadius;
 	int maskingDilateIterations;
+	std::string maskingEdge; // "hard", "rounded" or "feathered"
+	int maskingEdgeSize; // corner radius or feather width in pixels
 	bool trackingEnabled;
 	float zoomFactor;
 	float zoomSpeedFactor;
@@ -32,6 +159,9 @@ struct filter_data {
 	cv::Rect2f trackingRect;
 	int lastDetectedObjectId;
 	bool sortTracking;
+	std::string trackerMode; // "sort", or "bytetrack" to also track low-confidence detections
+	float trackLowThreshold; // lowest confidence of the detections handed to ByteTrack
+	std::string nmsMode;
 	bool showUnseenObjects;
 	std::string saveDetectionsPath;
 	bool crop_enabled;
@@ -39,30 +169,89 @@ struct filter_data {
 	int crop_right;
 	int crop_top;
 	int crop_bottom;
+	bool logStats;
+	float logStatsElapsed;
+	int batchMaxSize;
+	int batchMaxWait; // ms
+	int readbackLatency; // frames between staging and mapping a frame, 0 maps at once
 
 	// create SORT tracker
 	Sort tracker;
 
 	obs_source_t *source;
 	gs_texrender_t *texrender;
-	gs_stagesurf_t *stagesurface;
+	// the inference region of the frame scaled down to the model input, see
+	// getRGBAFromStageSurface
+	gs_texrender_t *readbackTexrender;
+	// the masking coverage of the detected boxes, rasterized on the GPU, see render_box_mask
+	gs_texrender_t *maskTexrender;
+	// the pixelated region of the frame, see pixelate_image
+	gs_texrender_t *pixelateTexrender;
+	// the masking blur: the downsampled levels and the full size result, see blur_image
+	gs_texrender_t *blurPyramid[BLUR_PYRAMID_LEVELS];
+	gs_texrender_t *blurTexrender;
+	// ring of stage surfaces, a frame is mapped readbackLatency renders after it was staged
+	// so that the map does not wait for the GPU to finish the copy
+	stage_slot stageSlots[STAGE_SURFACE_COUNT];
+	uint32_t stageIndex;
 	gs_effect_t *kawaseBlurEffect;
 	gs_effect_t *maskingEffect;
 	gs_effect_t *pixelateEffect;
+	gs_effect_t *overlayEffect;
+	// the boxes and labels of the preview, drawn over the frame in the render
+	PreviewOverlay previewOverlay;
+
+	// frame buffers shared by the render thread and the detection worker
+	FramePool framePool;
 
-	cv::Mat inputBGRA;
-	cv::Mat outputPreviewBGRA;
-	cv::Mat outputMask;
+	// latest captured frame, from the render thread to the detection worker
+	TripleBuffer<captured_frame> input;
+	// latest results, from the detection worker to the video tick and render, which both
+	// run on the graphics thread
+	TripleBuffer<detect_output> output;
 
 	bool isDisabled;
 	bool preview;
 
-	std::mutex inputBGRALock;
-	std::mutex outputLock;
 	std::mutex modelMutex;
 
+	std::thread workerThread;
+	// only for the worker to sleep until a frame is published, the frames do not need it
+	std::mutex inputWakeLock;
+	std::condition_variable inputCondition;
+	bool workerStop;
+	detect_stats stats;
+	// detections of the last model run, reused while the motion gate skips frames
+	std::vector<Object> lastDetections;
+	// the model of the last run, published with the detections until the next run
+	std::shared_ptr<const model_info> lastModelInfo;
+	motion_gate motionGate;
+	// adaptive inference rate, see detect_filter_inference_interval_ms
+	std::chrono::steady_clock::time_point lastInferenceTime;
+	double inferenceLatencyMs; // moving average of the model run time
+
+	// background model loader, only the latest pending request is kept
+	std::thread loaderThread;
+	std::mutex loaderLock;
+	std::condition_variable loaderCondition;
+	std::unique_ptr<model_load_request> pendingLoad;
+	uint64_t modelGeneration;
+	bool loaderStop;
+
 	std::unique_ptr<ONNXRuntimeModel> onnxruntimemodel;
-	std::vector<std::string> classNames;
+	// set by the loader once the first model is swapped in, for the graphics thread that
+	// never takes modelMutex
+	std::atomic<bool> modelReady;
+	// swapped in together with the model, guarded by modelMutex
+	std::shared_ptr<const model_info> modelInfo;
+	// the settings the model was configured with, guarded by modelMutex
+	model_config modelConfig;
+	// categories and size limits applied while decoding, guarded by modelMutex
+	DetectionQuery detectionQuery;
+	// the latest settings of the update, taken by the worker or the loader under modelMutex
+	std::mutex configLock;
+	model_config pendingConfig;
+	std::atomic<bool> configPending;
 
 #if _WIN32
 	std::wstring modelFilepath;
@@ -0,0 +1,43 @@
+#include "FramePool.h"
+
+#include <utility>
+
+// released buffers kept for reuse, the oldest are freed beyond that
+static const size_t MAX_FREE_FRAMES = 8;
+
+cv::Mat FramePool::acquire(const cv::Size &size, int type)
+{
+	this->acquired_++;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		for (size_t i = 0; i < this->free_.size(); i++) {
+			if (this->free_[i].size() == size && this->free_[i].type() == type) {
+				cv::Mat frame = std::move(this->free_[i]);
+				this->free_.erase(this->free_.begin() + (std::ptrdiff_t)i);
+				return frame;
+			}
+		}
+	}
+
+	cv::Mat frame(size, type);
+	this->allocations_++;
+	this->allocated_bytes_ += (uint64_t)(frame.total() * frame.elemSize());
+	return frame;
+}
+
+void FramePool::release(cv::Mat &frame)
+{
+	if (frame.empty() || frame.isSubmatrix() || frame.u == nullptr ||
+	    frame.u->refcount > 1) {
+		// views, borrowed memory and buffers still shared elsewhere are not pooled
+		frame.release();
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(this->mutex_);
+	if (this->free_.size() >= MAX_FREE_FRAMES) {
+		this->free_.erase(this->free_.begin());
+	}
+	this->free_.push_back(std::move(frame));
+	frame.release();
+}
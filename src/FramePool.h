@@ -0,0 +1,49 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Recycles the frame-sized buffers of a filter
+ *
+ * Buffers are taken with acquire() and handed back with release() once they are no longer
+ * needed, so that a steady stream of frames of the same size and type reuses the same
+ * memory instead of allocating new buffers every frame. Thread safe, the render thread and
+ * the detection worker share one pool.
+ */
+class FramePool {
+public:
+	struct Stats {
+		uint64_t acquired;
+		uint64_t allocations;
+		uint64_t allocated_bytes;
+	};
+
+	// A buffer of the given size and type with undefined content
+	cv::Mat acquire(const cv::Size &size, int type);
+
+	// Return the buffer to the pool, `frame` is left empty
+	void release(cv::Mat &frame);
+
+	// Counters since the last call, a pool in steady state reports no allocations
+	Stats takeStats()
+	{
+		return {acquired_.exchange(0), allocations_.exchange(0),
+			allocated_bytes_.exchange(0)};
+	}
+
+private:
+	std::mutex mutex_;
+	std::vector<cv::Mat> free_;
+
+	std::atomic<uint64_t> acquired_{0};
+	std::atomic<uint64_t> allocations_{0};
+	std::atomic<uint64_t> allocated_bytes_{0};
+};
+
+#endif // FRAME_POOL_H
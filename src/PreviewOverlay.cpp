@@ -0,0 +1,260 @@
+#include "PreviewOverlay.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "ort-model/utils.hpp"
+#include "plugin-support.h"
+
+// the font of the labels, as the preview drew them with cv::putText
+static const int FONT_FACE = cv::FONT_HERSHEY_SIMPLEX;
+static const double FONT_SCALE = 0.4;
+static const int FONT_THICKNESS = 1;
+// the printable ASCII characters are in the atlas
+static const char FIRST_GLYPH = ' ';
+static const char LAST_GLYPH = '~';
+// room around every glyph of the atlas for the antialiased strokes
+static const int GLYPH_PADDING = 2;
+// the line of the object id below the label
+static const float ID_LINE_OFFSET = 15.0f;
+// vertex buffers start with room for this many vertices
+static const size_t MIN_VERTEX_CAPACITY = 1024;
+
+// a color of the vertex buffer from OpenCV's BGR color list
+static uint32_t bgr_color(const float bgr[3], float scale)
+{
+	const uint32_t b = (uint32_t)std::min(bgr[0] * scale * 255.0f, 255.0f);
+	const uint32_t g = (uint32_t)std::min(bgr[1] * scale * 255.0f, 255.0f);
+	const uint32_t r = (uint32_t)std::min(bgr[2] * scale * 255.0f, 255.0f);
+	return r | (g << 8) | (b << 16) | 0xFF000000u;
+}
+
+static const uint32_t BLACK = 0xFF000000u;
+static const uint32_t WHITE = 0xFFFFFFFFu;
+static const uint32_t GREEN = 0xFF00FF00u;
+
+bool PreviewOverlay::createAtlas()
+{
+	int baseline = 0;
+	const cv::Size capSize = cv::getTextSize("A", FONT_FACE, FONT_SCALE, FONT_THICKNESS,
+						 &baseline);
+	this->textHeight_ = (float)capSize.height;
+	this->textBaseline_ = (float)baseline;
+
+	std::vector<int> widths;
+	int atlasWidth = 0;
+	for (char c = FIRST_GLYPH; c <= LAST_GLYPH; c++) {
+		const int width = cv::getTextSize(std::string(1, c), FONT_FACE, FONT_SCALE,
+						  FONT_THICKNESS, &baseline)
+					  .width;
+		widths.push_back(width);
+		atlasWidth += width + 2 * GLYPH_PADDING;
+	}
+	const int atlasHeight = capSize.height + baseline + 2 * GLYPH_PADDING;
+	this->cellHeight_ = (float)atlasHeight;
+
+	cv::Mat atlas(atlasHeight, atlasWidth, CV_8UC1, cv::Scalar(0));
+	this->glyphs_.clear();
+	int x = 0;
+	for (char c = FIRST_GLYPH; c <= LAST_GLYPH; c++) {
+		const int width = widths[(size_t)(c - FIRST_GLYPH)];
+		const int cellWidth = width + 2 * GLYPH_PADDING;
+		cv::putText(atlas, std::string(1, c),
+			    cv::Point(x + GLYPH_PADDING, GLYPH_PADDING + capSize.height), FONT_FACE,
+			    FONT_SCALE, cv::Scalar(255), FONT_THICKNESS, cv::LINE_AA);
+		// getTextSize adds the stroke thickness to the advance of the text once
+		this->glyphs_.push_back({(float)x / (float)atlasWidth,
+					 (float)(x + cellWidth) / (float)atlasWidth,
+					 (float)cellWidth, (float)(width - FONT_THICKNESS)});
+		x += cellWidth;
+	}
+
+	const uint8_t *data = atlas.data;
+	this->atlas_ =
+		gs_texture_create((uint32_t)atlasWidth, (uint32_t)atlasHeight, GS_R8, 1, &data, 0);
+	this->allocations_++;
+	if (this->atlas_ == nullptr) {
+		// retrying every frame would fail the same way, the preview is drawn without overlay
+		obs_log(LOG_ERROR, "Failed to create the %dx%d preview label atlas", atlasWidth,
+			atlasHeight);
+		this->atlasFailed_ = true;
+		return false;
+	}
+	return true;
+}
+
+void PreviewOverlay::addQuad(std::vector<Vertex> &vertices, float x0, float y0, float x1,
+			     float y1, uint32_t color, float u0, float v0, float u1, float v1)
+{
+	vertices.push_back({x0, y0, color, u0, v0});
+	vertices.push_back({x1, y0, color, u1, v0});
+	vertices.push_back({x0, y1, color, u0, v1});
+	vertices.push_back({x1, y0, color, u1, v0});
+	vertices.push_back({x1, y1, color, u1, v1});
+	vertices.push_back({x0, y1, color, u0, v1});
+}
+
+void PreviewOverlay::addOutline(const cv::Rect_<float> &rect, float thickness, uint32_t color)
+{
+	// the strokes are centered on the edges of the rectangle, like cv::rectangle draws them
+	const float h = thickness * 0.5f;
+	const float left = rect.x;
+	const float top = rect.y;
+	const float right = rect.x + rect.width;
+	const float bottom = rect.y + rect.height;
+	addQuad(this->solids_, left - h, top - h, right + h, top + h, color);
+	addQuad(this->solids_, left - h, bottom - h, right + h, bottom + h, color);
+	addQuad(this->solids_, left - h, top + h, left + h, bottom - h, color);
+	addQuad(this->solids_, right - h, top + h, right + h, bottom - h, color);
+}
+
+void PreviewOverlay::addDashedOutline(const cv::Rect &rect, float thickness, float dashLength,
+				      uint32_t color)
+{
+	const float h = thickness * 0.5f;
+	const float left = (float)rect.x;
+	const float top = (float)rect.y;
+	const float right = (float)(rect.x + rect.width);
+	const float bottom = (float)(rect.y + rect.height);
+	// every edge starts with a dash at its corner
+	for (float d = 0.0f; d < (float)rect.width; d += 2.0f * dashLength) {
+		const float end = std::min(d + dashLength, (float)rect.width);
+		addQuad(this->solids_, left + d, top - h, left + end, top + h, color);
+		addQuad(this->solids_, right - end, bottom - h, right - d, bottom + h, color);
+	}
+	for (float d = 0.0f; d < (float)rect.height; d += 2.0f * dashLength) {
+		const float end = std::min(d + dashLength, (float)rect.height);
+		addQuad(this->solids_, right - h, top + d, right + h, top + end, color);
+		addQuad(this->solids_, left - h, bottom - end, left + h, bottom - d, color);
+	}
+}
+
+float PreviewOverlay::textWidth(const std::string &text) const
+{
+	float width = (float)FONT_THICKNESS;
+	for (char c : text) {
+		const char glyph = (c < FIRST_GLYPH || c > LAST_GLYPH) ? FIRST_GLYPH : c;
+		width += this->glyphs_[(size_t)(glyph - FIRST_GLYPH)].advance;
+	}
+	return width;
+}
+
+void PreviewOverlay::addText(const std::string &text, float x, float baseline, uint32_t color)
+{
+	const float top = baseline - this->textHeight_ - (float)GLYPH_PADDING;
+	for (char c : text) {
+		const char glyph = (c < FIRST_GLYPH || c > LAST_GLYPH) ? FIRST_GLYPH : c;
+		const Glyph &g = this->glyphs_[(size_t)(glyph - FIRST_GLYPH)];
+		if (glyph != ' ') {
+			const float left = x - (float)GLYPH_PADDING;
+			addQuad(this->glyphVertices_, left, top, left + g.width,
+				top + this->cellHeight_, color, g.u0, 0.0f, g.u1, 1.0f);
+		}
+		x += g.advance;
+	}
+}
+
+void PreviewOverlay::drawVertices(gs_effect_t *effect, const char *technique,
+				  VertexBuffer &buffer, const std::vector<Vertex> &vertices)
+{
+	if (vertices.empty()) {
+		return;
+	}
+	if (vertices.size() > buffer.capacity) {
+		gs_vertexbuffer_destroy(buffer.buffer);
+		buffer.capacity =
+			std::max({vertices.size(), 2 * buffer.capacity, MIN_VERTEX_CAPACITY});
+		struct gs_vb_data *data = gs_vbdata_create();
+		data->num = buffer.capacity;
+		data->points = (struct vec3 *)bzalloc(sizeof(struct vec3) * buffer.capacity);
+		data->colors = (uint32_t *)bzalloc(sizeof(uint32_t) * buffer.capacity);
+		data->num_tex = 1;
+		data->tvarray = (struct gs_tvertarray *)bzalloc(sizeof(struct gs_tvertarray));
+		data->tvarray[0].width = 2;
+		data->tvarray[0].array = bzalloc(sizeof(struct vec2) * buffer.capacity);
+		buffer.buffer = gs_vertexbuffer_create(data, GS_DYNAMIC);
+		this->allocations_++;
+		if (buffer.buffer == nullptr) {
+			buffer.capacity = 0;
+			return;
+		}
+	}
+
+	struct gs_vb_data *data = gs_vertexbuffer_get_data(buffer.buffer);
+	struct vec2 *uvs = (struct vec2 *)data->tvarray[0].array;
+	for (size_t i = 0; i < vertices.size(); i++) {
+		const Vertex &vertex = vertices[i];
+		vec3_set(&data->points[i], vertex.x, vertex.y, 0.0f);
+		data->colors[i] = vertex.color;
+		vec2_set(&uvs[i], vertex.u, vertex.v);
+	}
+	gs_vertexbuffer_flush(buffer.buffer);
+
+	gs_load_vertexbuffer(buffer.buffer);
+	gs_load_indexbuffer(nullptr);
+	while (gs_effect_loop(effect, technique)) {
+		gs_draw(GS_TRIS, 0, (uint32_t)vertices.size());
+	}
+	gs_load_vertexbuffer(nullptr);
+}
+
+void PreviewOverlay::draw(gs_effect_t *effect, const std::vector<Object> &objects,
+			  const std::vector<std::string> &classNames, const cv::Rect &crop)
+{
+	if (effect == nullptr || this->atlasFailed_ ||
+	    (this->atlas_ == nullptr && !createAtlas())) {
+		return;
+	}
+	this->solids_.clear();
+	this->glyphVertices_.clear();
+
+	if (!crop.empty()) {
+		addDashedOutline(crop, 5.0f, 15.0f, GREEN);
+	}
+
+	char text[256];
+	for (const Object &obj : objects) {
+		// objects of an unknown class (negative label) get the color of the first class
+		const float *color = color_list[obj.label >= 0 ? obj.label % 80 : 0];
+		// the mean of the color as a cv::Scalar, whose fourth channel is zero
+		const uint32_t textColor = (color[0] + color[1] + color[2]) / 4.0f > 0.5f ? BLACK
+											   : WHITE;
+		addOutline(obj.rect, 2.0f, bgr_color(color, 1.0f));
+
+		const char *className = (obj.label >= 0 && (size_t)obj.label < classNames.size())
+						? classNames[(size_t)obj.label].c_str()
+						: "?";
+		snprintf(text, sizeof(text), "%s %.1f%%", className, obj.prob * 100);
+		const float x = std::floor(obj.rect.x);
+		const float y = std::floor(obj.rect.y + 1.0f);
+		addQuad(this->solids_, x, y, x + textWidth(text),
+			y + this->textHeight_ + this->textBaseline_, bgr_color(color, 0.7f));
+		addText(text, x, y + this->textHeight_, textColor);
+
+		// the id of the object on the line below
+		snprintf(text, sizeof(text), "ID: %d", (int)obj.id);
+		addText(text, x, y + this->textHeight_ + ID_LINE_OFFSET, textColor);
+	}
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA);
+	drawVertices(effect, "Solid", this->solidBuffer_, this->solids_);
+	gs_effect_set_texture(gs_effect_get_param_by_name(effect, "atlas"), this->atlas_);
+	drawVertices(effect, "Glyph", this->glyphBuffer_, this->glyphVertices_);
+	gs_blend_state_pop();
+}
+
+void PreviewOverlay::destroy()
+{
+	gs_vertexbuffer_destroy(this->solidBuffer_.buffer);
+	gs_vertexbuffer_destroy(this->glyphBuffer_.buffer);
+	gs_texture_destroy(this->atlas_);
+	this->solidBuffer_ = VertexBuffer();
+	this->glyphBuffer_ = VertexBuffer();
+	this->atlas_ = nullptr;
+	// a new graphics context may create the atlas again
+	this->atlasFailed_ = false;
+}
@@ -0,0 +1,87 @@
+#ifndef PREVIEW_OVERLAY_H
+#define PREVIEW_OVERLAY_H
+
+#include <obs-module.h>
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ort-model/types.hpp"
+
+/**
+ * @brief Draws the detections of the preview over the frame on the GPU
+ *
+ * The boxes, the label backgrounds and the dashed crop outline are triangles in a dynamic
+ * vertex buffer. The label text is drawn from a glyph atlas rasterized once with the OpenCV
+ * font that the preview was drawn with on the CPU. The vertex buffers and the atlas are kept
+ * between frames, a buffer is only reallocated when a frame needs more vertices than it holds.
+ * Graphics thread only.
+ */
+class PreviewOverlay {
+public:
+	// Draw over the current render target, whose coordinates are source frame pixels. The
+	// crop is drawn as a dashed outline unless it is empty.
+	void draw(gs_effect_t *effect, const std::vector<Object> &objects,
+		  const std::vector<std::string> &classNames, const cv::Rect &crop);
+
+	// Free the GPU resources, inside the graphics context
+	void destroy();
+
+	// GPU allocations since the last call, none in steady state
+	uint64_t takeAllocations() { return std::exchange(allocations_, (uint64_t)0); }
+
+private:
+	struct Vertex {
+		float x;
+		float y;
+		uint32_t color;
+		float u;
+		float v;
+	};
+
+	struct VertexBuffer {
+		gs_vertbuffer_t *buffer = nullptr;
+		size_t capacity = 0;
+	};
+
+	// A character of the atlas, pen positions advance by `advance` pixels
+	struct Glyph {
+		float u0;
+		float u1;
+		float width;
+		float advance;
+	};
+
+	bool createAtlas();
+	void addQuad(std::vector<Vertex> &vertices, float x0, float y0, float x1, float y1,
+		     uint32_t color, float u0 = 0.0f, float v0 = 0.0f, float u1 = 0.0f,
+		     float v1 = 0.0f);
+	void addOutline(const cv::Rect_<float> &rect, float thickness, uint32_t color);
+	void addDashedOutline(const cv::Rect &rect, float thickness, float dashLength,
+			      uint32_t color);
+	float textWidth(const std::string &text) const;
+	void addText(const std::string &text, float x, float baseline, uint32_t color);
+	void drawVertices(gs_effect_t *effect, const char *technique, VertexBuffer &buffer,
+			  const std::vector<Vertex> &vertices);
+
+	std::vector<Vertex> solids_;
+	std::vector<Vertex> glyphVertices_;
+	VertexBuffer solidBuffer_;
+	VertexBuffer glyphBuffer_;
+
+	gs_texture_t *atlas_ = nullptr;
+	// the atlas could not be created, it is not retried until destroy()
+	bool atlasFailed_ = false;
+	std::vector<Glyph> glyphs_;
+	float cellHeight_ = 0.0f;
+	// height of the capital letters and depth below the baseline, as cv::getTextSize reports
+	float textHeight_ = 0.0f;
+	float textBaseline_ = 0.0f;
+
+	uint64_t allocations_ = 0;
+};
+
+#endif // PREVIEW_OVERLAY_H
@@ -0,0 +1,63 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free handoff of the latest value from one producer thread to one consumer thread
+ *
+ * The producer fills the write buffer and publishes it, the consumer picks up the latest
+ * published buffer with update(). The two sides own one buffer each and swap with the third,
+ * shared, buffer through a single atomic, so neither side ever waits for the other or copies
+ * a buffer. A buffer published before the consumer picked up the previous one replaces it.
+ *
+ * Buffers are recycled: the write buffer holds whatever an earlier value left in it, so the
+ * producer must overwrite every field, and containers keep their capacity across values.
+ */
+template<typename T> class TripleBuffer {
+public:
+	// Producer: the buffer to fill before publish()
+	T &writeBuffer() { return this->buffers_[this->write_]; }
+
+	// Producer: hand the write buffer to the consumer and continue with the shared one.
+	// Returns false when the previously published buffer was never picked up.
+	bool publish()
+	{
+		const uint8_t previous = this->shared_.exchange((uint8_t)(this->write_ | FRESH),
+								std::memory_order_acq_rel);
+		this->write_ = (uint8_t)(previous & INDEX_MASK);
+		return (previous & FRESH) == 0;
+	}
+
+	// Consumer: whether a buffer was published since the last update()
+	bool hasNew() const { return (this->shared_.load(std::memory_order_acquire) & FRESH) != 0; }
+
+	// Consumer: switch to the latest published buffer, returns false when there is none
+	bool update()
+	{
+		if (!this->hasNew()) {
+			return false;
+		}
+		this->read_ = (uint8_t)(this->shared_.exchange(this->read_,
+							       std::memory_order_acq_rel) &
+					INDEX_MASK);
+		return true;
+	}
+
+	// Consumer: the buffer picked up by the last update(), stays valid until the next one
+	T &readBuffer() { return this->buffers_[this->read_]; }
+
+private:
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t FRESH = 0x4;
+
+	T buffers_[3];
+	// only touched by the producer and the consumer thread respectively
+	uint8_t write_ = 0;
+	uint8_t read_ = 1;
+	// index of the shared buffer and whether it holds an unread value
+	alignas(64) std::atomic<uint8_t> shared_{2};
+};
+
+#endif // TRIPLE_BUFFER_H
@@ -7,7 +7,7 @@
 #include <windows.h>
 #endif // _WIN32
 
-#include <opencv2/imgproc.hpp>
+#include <opencv2/core.hpp>
 
 #include <numeric>
 #include <memory>
@@ -25,7 +25,8 @@
 #include "consts.h"
 #include "obs-utils/obs-utils.h"
 #include "ort-model/utils.hpp"
-#include "detect-filter-utils.h"
+#include "ort-model/tiling.h"
+#include "motion-gate.h"
 #include "edgeyolo/edgeyolo_onnxruntime.hpp"
 #include "yunet/YuNet.h"
 
@@ -58,8 +59,12 @@ static bool enable_advanced_settings(obs_properties_t *ppts, obs_property_t *p,
 
 	for (const char *prop_name :
 	     {"threshold", "useGPU", "numThreads", "model_size", "detected_object", "sort_tracking",
-	      "max_unseen_frames", "show_unseen_objects", "save_detections_path", "crop_group",
-	      "min_size_threshold"}) {
+	      "tracker_mode", "track_low_threshold", "max_unseen_frames", "show_unseen_objects",
+	      "save_detections_path", "crop_group", "min_size_threshold", "max_size_threshold",
+	      "max_detections", "log_stats", "batch_max_size", "batch_max_wait", "tiled_inference",
+	      "tile_overlap", "tile_full_frame", "motion_gating", "motion_threshold",
+	      "motion_max_skip", "max_inference_fps", "inference_budget", "nms_mode",
+	      "readback_latency"}) {
 		p = obs_properties_get(ppts, prop_name);
 		obs_property_set_visible(p, enabled);
 	}
@@ -98,7 +103,7 @@ void set_class_names_on_object_category(obs_property_t *object_category,
 }
 
 void read_model_config_json_and_set_class_names(const char *model_file, obs_properties_t *props_,
-						obs_data_t *settings, struct detect_filter *tf_)
+						obs_data_t *settings)
 {
 	if (model_file == nullptr || model_file[0] == '\0' || strlen(model_file) == 0) {
 		obs_log(LOG_ERROR, "Model file path is empty");
@@ -121,7 +126,6 @@ void read_model_config_json_and_set_class_names(const char *model_file, obs_prop
 			std::vector<std::string> labels = j["names"];
 			set_class_names_on_object_category(
 				obs_properties_get(props_, "object_category"), labels);
-			tf_->classNames = labels;
 		} else {
 			obs_data_set_string(settings, "error",
 					    "JSON file does not contain 'names' field");
@@ -132,8 +136,6 @@ void read_model_config_json_and_set_class_names(const char *model_file, obs_prop
 
 obs_properties_t *detect_filter_properties(void *data)
 {
-	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
-
 	obs_properties_t *props = obs_properties_create();
 
 	obs_properties_add_bool(props, "preview", obs_module_text("Preview"));
@@ -143,7 +145,10 @@ obs_properties_t *detect_filter_properties(void *data)
 		obs_properties_add_list(props, "object_category", obs_module_text("ObjectCategory"),
 					OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
 	set_class_names_on_object_category(object_category, edgeyolo_cpp::COCO_CLASSES);
-	tf->classNames = edgeyolo_cpp::COCO_CLASSES;
+	// more categories by class name, detected together with the selected category
+	obs_properties_add_editable_list(props, "object_categories",
+					 obs_module_text("ObjectCategories"),
+					 OBS_EDITABLE_LIST_TYPE_STRINGS, nullptr, nullptr);
 
 	// options group for masking
 	obs_properties_t *masking_group = obs_properties_create();
@@ -167,6 +172,9 @@ obs_properties_t *detect_filter_properties(void *data)
 		obs_property_set_visible(masking_color, false);
 		obs_property_set_visible(masking_blur_radius, false);
 		obs_property_set_visible(masking_dilation, enabled);
+		obs_property_set_visible(obs_properties_get(props_, "masking_edge"), enabled);
+		obs_property_set_visible(obs_properties_get(props_, "masking_edge_size"),
+					 enabled);
 		std::string masking_type_value = obs_data_get_string(settings, "masking_type");
 		if (masking_type_value == "solid_color") {
 			obs_property_set_visible(masking_color, enabled);
@@ -209,6 +217,10 @@ obs_properties_t *detect_filter_properties(void *data)
 		obs_property_set_visible(masking_blur_radius, false);
 		const bool masking_enabled = obs_data_get_bool(settings, "masking_group");
 		obs_property_set_visible(masking_dilation, masking_enabled);
+		obs_property_set_visible(obs_properties_get(props_, "masking_edge"),
+					 masking_enabled);
+		obs_property_set_visible(obs_properties_get(props_, "masking_edge_size"),
+					 masking_enabled);
 
 		if (masking_type_value == "solid_color") {
 			obs_property_set_visible(masking_color, masking_enabled);
@@ -222,6 +234,19 @@ obs_properties_t *detect_filter_properties(void *data)
 	obs_properties_add_int_slider(masking_group, "dilation_iterations",
 				      obs_module_text("DilationIterations"), 0, 20, 1);
 
+	// add the shape of the mask edges and their size
+	obs_property_t *masking_edge = obs_properties_add_list(masking_group, "masking_edge",
+							       obs_module_text("MaskingEdge"),
+							       OBS_COMBO_TYPE_LIST,
+							       OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(masking_edge, obs_module_text("MaskingEdgeHard"), "hard");
+	obs_property_list_add_string(masking_edge, obs_module_text("MaskingEdgeRounded"),
+				     "rounded");
+	obs_property_list_add_string(masking_edge, obs_module_text("MaskingEdgeFeathered"),
+				     "feathered");
+	obs_properties_add_int_slider(masking_group, "masking_edge_size",
+				      obs_module_text("MaskingEdgeSize"), 1, 100, 1);
+
 	// add options group for tracking and zoom-follow options
 	obs_properties_t *tracking_group_props = obs_properties_create();
 	obs_property_t *tracking_group = obs_properties_add_group(
@@ -304,9 +329,56 @@ obs_properties_t *detect_filter_properties(void *data)
 	obs_properties_add_int_slider(props, "min_size_threshold",
 				      obs_module_text("MinSizeThreshold"), 0, 10000, 1);
 
+	// add maximal size and count limits, 0 for no limit
+	obs_properties_add_int_slider(props, "max_size_threshold",
+				      obs_module_text("MaxSizeThreshold"), 0, 1000000, 100);
+	obs_properties_add_int_slider(props, "max_detections", obs_module_text("MaxDetections"),
+				      0, 100, 1);
+
+	// add sliced inference settings for small objects on high resolution sources
+	obs_properties_add_bool(props, "tiled_inference", obs_module_text("TiledInference"));
+	obs_properties_add_float_slider(props, "tile_overlap", obs_module_text("TileOverlap"), 0.0,
+					0.5, 0.05);
+	obs_properties_add_bool(props, "tile_full_frame", obs_module_text("TileFullFrame"));
+
+	// add motion gating settings to skip inference on unchanged frames
+	obs_properties_add_bool(props, "motion_gating", obs_module_text("MotionGating"));
+	obs_properties_add_float_slider(props, "motion_threshold",
+					obs_module_text("MotionThreshold"), 0.0, 10.0, 0.1);
+	obs_properties_add_int_slider(props, "motion_max_skip", obs_module_text("MotionMaxSkip"),
+				      0, 300, 1);
+
+	// add inference rate limits, tracked objects are extrapolated between model runs
+	obs_properties_add_int_slider(props, "max_inference_fps",
+				      obs_module_text("MaxInferenceFps"), 0, 60, 1);
+	obs_properties_add_int_slider(props, "inference_budget",
+				      obs_module_text("InferenceBudget"), 0, 100, 5);
+
+	// add the non-maximum suppression mode
+	obs_property_t *nms_mode = obs_properties_add_list(props, "nms_mode",
+							   obs_module_text("NmsMode"),
+							   OBS_COMBO_TYPE_LIST,
+							   OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(nms_mode, obs_module_text("NmsAgnostic"), "agnostic");
+	obs_property_list_add_string(nms_mode, obs_module_text("NmsClassAware"), "class_aware");
+	obs_property_list_add_string(nms_mode, obs_module_text("NmsSoft"), "soft");
+
 	// add SORT tracking enabled checkbox
 	obs_properties_add_bool(props, "sort_tracking", obs_module_text("SORTTracking"));
 
+	// add the tracker association mode
+	obs_property_t *tracker_mode = obs_properties_add_list(props, "tracker_mode",
+							       obs_module_text("TrackerMode"),
+							       OBS_COMBO_TYPE_LIST,
+							       OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(tracker_mode, obs_module_text("TrackerModeSort"), "sort");
+	obs_property_list_add_string(tracker_mode, obs_module_text("TrackerModeByteTrack"),
+				     "bytetrack");
+
+	// add the confidence down to which detections keep existing tracks alive
+	obs_properties_add_float_slider(props, "track_low_threshold",
+					obs_module_text("TrackLowThreshold"), 0.0, 1.0, 0.025);
+
 	// add parameter for number of missing frames before a track is considered lost
 	obs_properties_add_int(props, "max_unseen_frames", obs_module_text("MaxUnseenFrames"), 1,
 			       30, 1);
@@ -319,6 +391,20 @@ obs_properties_t *detect_filter_properties(void *data)
 				obs_module_text("SaveDetectionsPath"), OBS_PATH_FILE_SAVE,
 				"JSON file (*.json);;All files (*.*)", nullptr);
 
+	// add option to periodically log performance stats of the detection worker
+	obs_properties_add_bool(props, "log_stats", obs_module_text("LogStats"));
+
+	// batching of inference requests from filters sharing a model (dynamic batch models only)
+	obs_properties_add_int_slider(props, "batch_max_size", obs_module_text("BatchMaxSize"), 1,
+				      16, 1);
+	obs_properties_add_int_slider(props, "batch_max_wait", obs_module_text("BatchMaxWait"), 0,
+				      50, 1);
+
+	// frames of delay of the GPU readback, avoids stalling the render on the copy
+	obs_properties_add_int_slider(props, "readback_latency",
+				      obs_module_text("ReadbackLatency"), 0,
+				      STAGE_SURFACE_COUNT - 1, 1);
+
 	/* GPU, CPU and performance Props */
 	obs_property_t *p_use_gpu =
 		obs_properties_add_list(props, "useGPU", obs_module_text("InferenceDevice"),
@@ -355,11 +441,9 @@ obs_properties_t *detect_filter_properties(void *data)
 				nullptr);
 
 	// add callback to show/hide the external model file path
-	obs_property_set_modified_callback2(
-		model_size,
-		[](void *data_, obs_properties_t *props_, obs_property_t *p, obs_data_t *settings) {
+	obs_property_set_modified_callback(
+		model_size, [](obs_properties_t *props_, obs_property_t *p, obs_data_t *settings) {
 			UNUSED_PARAMETER(p);
-			struct detect_filter *tf_ = reinterpret_cast<detect_filter *>(data_);
 			std::string model_size_value = obs_data_get_string(settings, "model_size");
 			bool is_external = model_size_value == EXTERNAL_MODEL_SIZE;
 			obs_property_t *prop = obs_properties_get(props_, "external_model_file");
@@ -370,43 +454,37 @@ obs_properties_t *detect_filter_properties(void *data)
 					set_class_names_on_object_category(
 						obs_properties_get(props_, "object_category"),
 						yunet::FACE_CLASSES);
-					tf_->classNames = yunet::FACE_CLASSES;
 				} else {
 					// reset the class names to COCO classes for default models
 					set_class_names_on_object_category(
 						obs_properties_get(props_, "object_category"),
 						edgeyolo_cpp::COCO_CLASSES);
-					tf_->classNames = edgeyolo_cpp::COCO_CLASSES;
 				}
 			} else {
 				// if the model path is already set - update the class names
 				const char *model_file =
 					obs_data_get_string(settings, "external_model_file");
 				read_model_config_json_and_set_class_names(model_file, props_,
-									   settings, tf_);
+									   settings);
 			}
 			return true;
-		},
-		tf);
+		});
 
 	// add callback on the model file path to check if the file exists
-	obs_property_set_modified_callback2(
+	obs_property_set_modified_callback(
 		obs_properties_get(props, "external_model_file"),
-		[](void *data_, obs_properties_t *props_, obs_property_t *p, obs_data_t *settings) {
+		[](obs_properties_t *props_, obs_property_t *p, obs_data_t *settings) {
 			UNUSED_PARAMETER(p);
 			const char *model_size_value = obs_data_get_string(settings, "model_size");
 			bool is_external = strcmp(model_size_value, EXTERNAL_MODEL_SIZE) == 0;
 			if (!is_external) {
 				return true;
 			}
-			struct detect_filter *tf_ = reinterpret_cast<detect_filter *>(data_);
 			const char *model_file =
 				obs_data_get_string(settings, "external_model_file");
-			read_model_config_json_and_set_class_names(model_file, props_, settings,
-								   tf_);
+			read_model_config_json_and_set_class_names(model_file, props_, settings);
 			return true;
-		},
-		tf);
+		});
 
 	// Add a informative text about the plugin
 	std::string basic_info =
@@ -429,9 +507,23 @@ void detect_filter_defaults(obs_data_t *settings)
 	obs_data_set_default_string(settings, "useGPU", USEGPU_CPU);
 #endif
 	obs_data_set_default_bool(settings, "sort_tracking", false);
+	obs_data_set_default_string(settings, "tracker_mode", "sort");
+	obs_data_set_default_double(settings, "track_low_threshold", 0.1);
+	obs_data_set_default_string(settings, "nms_mode", "agnostic");
 	obs_data_set_default_int(settings, "max_unseen_frames", 10);
 	obs_data_set_default_bool(settings, "show_unseen_objects", true);
 	obs_data_set_default_int(settings, "numThreads", 1);
+	obs_data_set_default_bool(settings, "tiled_inference", false);
+	obs_data_set_default_double(settings, "tile_overlap", 0.2);
+	obs_data_set_default_bool(settings, "tile_full_frame", true);
+	obs_data_set_default_bool(settings, "motion_gating", false);
+	obs_data_set_default_double(settings, "motion_threshold", 0.5);
+	obs_data_set_default_int(settings, "motion_max_skip", 30);
+	obs_data_set_default_int(settings, "max_inference_fps", 0);
+	obs_data_set_default_int(settings, "inference_budget", 0);
+	obs_data_set_default_int(settings, "batch_max_size", 1);
+	obs_data_set_default_int(settings, "batch_max_wait", 5);
+	obs_data_set_default_int(settings, "readback_latency", 1);
 	obs_data_set_default_bool(settings, "preview", true);
 	obs_data_set_default_double(settings, "threshold", 0.5);
 	obs_data_set_default_string(settings, "model_size", "small");
@@ -441,6 +533,8 @@ void detect_filter_defaults(obs_data_t *settings)
 	obs_data_set_default_string(settings, "masking_color", "#000000");
 	obs_data_set_default_int(settings, "masking_blur_radius", 0);
 	obs_data_set_default_int(settings, "dilation_iterations", 0);
+	obs_data_set_default_string(settings, "masking_edge", "hard");
+	obs_data_set_default_int(settings, "masking_edge_size", 10);
 	obs_data_set_default_bool(settings, "tracking_group", false);
 	obs_data_set_default_double(settings, "zoom_factor", 0.0);
 	obs_data_set_default_double(settings, "zoom_speed_factor", 0.05);
@@ -451,6 +545,54 @@ void detect_filter_defaults(obs_data_t *settings)
 	obs_data_set_default_int(settings, "crop_right", 0);
 	obs_data_set_default_int(settings, "crop_top", 0);
 	obs_data_set_default_int(settings, "crop_bottom", 0);
+	obs_data_set_default_int(settings, "max_size_threshold", 0);
+	obs_data_set_default_int(settings, "max_detections", 0);
+	obs_data_set_default_bool(settings, "log_stats", false);
+}
+
+// take the latest settings of the update into modelConfig, call with modelMutex held. Returns
+// whether there were new settings.
+static bool detect_filter_take_config(struct detect_filter *tf)
+{
+	if (!tf->configPending.exchange(false)) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(tf->configLock);
+	tf->modelConfig = tf->pendingConfig;
+	return true;
+}
+
+// apply modelConfig to the model, call with modelMutex held
+static void detect_filter_configure_model(struct detect_filter *tf, ONNXRuntimeModel &model,
+					  const std::vector<std::string> &classNames)
+{
+	const model_config &config = tf->modelConfig;
+	model.setBBoxConfThresh(config.bboxConfThreshold);
+	model.setBatching(config.batchMaxSize, config.batchMaxWait);
+	model.setNmsMode(config.nmsMode);
+
+	// the categories and the size limits are filtered while decoding, before the NMS, the
+	// count limit stops the NMS early
+	DetectionQuery query;
+	if (config.objectCategory != -1) {
+		query.classes.push_back(config.objectCategory);
+	}
+	for (const std::string &name : config.objectCategoryNames) {
+		auto it = std::find(classNames.begin(), classNames.end(), name);
+		if (it == classNames.end()) {
+			obs_log(LOG_WARNING, "Unknown object category: %s", name.c_str());
+			continue;
+		}
+		query.classes.push_back((int)(it - classNames.begin()));
+	}
+	if (query.classes.empty() && !config.objectCategoryNames.empty()) {
+		// none of the listed categories exist in this model, detect nothing rather than all
+		query.classes.push_back(-1);
+	}
+	query.minArea = config.minArea;
+	query.maxArea = config.maxArea;
+	query.topK = config.topK;
+	tf->detectionQuery = query;
 }
 
 void detect_filter_update(void *data, obs_data_t *settings)
@@ -464,16 +606,32 @@ void detect_filter_update(void *data, obs_data_t *settings)
 	tf->preview = obs_data_get_bool(settings, "preview");
 	tf->conf_threshold = (float)obs_data_get_double(settings, "threshold");
 	tf->objectCategory = (int)obs_data_get_int(settings, "object_category");
+	std::vector<std::string> objectCategoryNames;
+	obs_data_array_t *objectCategories = obs_data_get_array(settings, "object_categories");
+	for (size_t i = 0; i < obs_data_array_count(objectCategories); i++) {
+		obs_data_t *item = obs_data_array_item(objectCategories, i);
+		const std::string name = obs_data_get_string(item, "value");
+		if (!name.empty()) {
+			objectCategoryNames.push_back(name);
+		}
+		obs_data_release(item);
+	}
+	obs_data_array_release(objectCategories);
 	tf->maskingEnabled = obs_data_get_bool(settings, "masking_group");
 	tf->maskingType = obs_data_get_string(settings, "masking_type");
 	tf->maskingColor = (int)obs_data_get_int(settings, "masking_color");
 	tf->maskingBlurRadius = (int)obs_data_get_int(settings, "masking_blur_radius");
 	tf->maskingDilateIterations = (int)obs_data_get_int(settings, "dilation_iterations");
+	tf->maskingEdge = obs_data_get_string(settings, "masking_edge");
+	tf->maskingEdgeSize = (int)obs_data_get_int(settings, "masking_edge_size");
 	bool newTrackingEnabled = obs_data_get_bool(settings, "tracking_group");
 	tf->zoomFactor = (float)obs_data_get_double(settings, "zoom_factor");
 	tf->zoomSpeedFactor = (float)obs_data_get_double(settings, "zoom_speed_factor");
 	tf->zoomObject = obs_data_get_string(settings, "zoom_object");
 	tf->sortTracking = obs_data_get_bool(settings, "sort_tracking");
+	tf->trackerMode = obs_data_get_string(settings, "tracker_mode");
+	tf->trackLowThreshold = (float)obs_data_get_double(settings, "track_low_threshold");
+	tf->nmsMode = obs_data_get_string(settings, "nms_mode");
 	size_t maxUnseenFrames = (size_t)obs_data_get_int(settings, "max_unseen_frames");
 	if (tf->tracker.getMaxUnseenFrames() != maxUnseenFrames) {
 		tf->tracker.setMaxUnseenFrames(maxUnseenFrames);
@@ -486,6 +644,20 @@ void detect_filter_update(void *data, obs_data_t *settings)
 	tf->crop_top = (int)obs_data_get_int(settings, "crop_top");
 	tf->crop_bottom = (int)obs_data_get_int(settings, "crop_bottom");
 	tf->minAreaThreshold = (int)obs_data_get_int(settings, "min_size_threshold");
+	tf->maxAreaThreshold = (int)obs_data_get_int(settings, "max_size_threshold");
+	tf->maxDetections = (int)obs_data_get_int(settings, "max_detections");
+	tf->tiledInference = obs_data_get_bool(settings, "tiled_inference");
+	tf->tileOverlap = (float)obs_data_get_double(settings, "tile_overlap");
+	tf->tileFullFrame = obs_data_get_bool(settings, "tile_full_frame");
+	tf->motionGating = obs_data_get_bool(settings, "motion_gating");
+	tf->motionThreshold = (float)obs_data_get_double(settings, "motion_threshold");
+	tf->motionMaxSkip = (int)obs_data_get_int(settings, "motion_max_skip");
+	tf->maxInferenceFps = (int)obs_data_get_int(settings, "max_inference_fps");
+	tf->inferenceBudget = (int)obs_data_get_int(settings, "inference_budget");
+	tf->logStats = obs_data_get_bool(settings, "log_stats");
+	tf->batchMaxSize = (int)obs_data_get_int(settings, "batch_max_size");
+	tf->batchMaxWait = (int)obs_data_get_int(settings, "batch_max_wait");
+	tf->readbackLatency = (int)obs_data_get_int(settings, "readback_latency");
 
 	// check if tracking state has changed
 	if (tf->trackingEnabled != newTrackingEnabled) {
@@ -532,8 +704,8 @@ void detect_filter_update(void *data, obs_data_t *settings)
 		obs_log(LOG_INFO, "Reinitializing model");
 		reinitialize = true;
 
-		// lock modelMutex
-		std::unique_lock<std::mutex> lock(tf->modelMutex);
+		// the current model keeps serving until the loader swaps in the new one
+		auto request = std::make_unique<model_load_request>();
 
 		char *modelFilepath_rawPtr = nullptr;
 		if (newModelSize == "small") {
@@ -554,52 +726,49 @@ void detect_filter_update(void *data, obs_data_t *settings)
 			if (external_model_file == nullptr || external_model_file[0] == '\0' ||
 			    strlen(external_model_file) == 0) {
 				obs_log(LOG_ERROR, "External model file path is empty");
-				tf->isDisabled = true;
-				return;
+				obs_data_set_string(settings, "error",
+						    "External model file path is empty");
+				request.reset();
+			} else {
+				modelFilepath_rawPtr = bstrdup(external_model_file);
 			}
-			modelFilepath_rawPtr = bstrdup(external_model_file);
 		} else {
 			obs_log(LOG_ERROR, "Invalid model size: %s", newModelSize.c_str());
-			tf->isDisabled = true;
-			return;
+			obs_data_set_string(settings, "error", "Invalid model size");
+			request.reset();
 		}
 
-		if (modelFilepath_rawPtr == nullptr) {
+		if (request && modelFilepath_rawPtr == nullptr) {
 			obs_log(LOG_ERROR, "Unable to get model filename from plugin.");
-			tf->isDisabled = true;
-			return;
+			obs_data_set_string(settings, "error", "Model file not found");
+			request.reset();
 		}
 
+		if (request) {
 #if _WIN32
-		int outLength = MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, modelFilepath_rawPtr,
-						    -1, nullptr, 0);
-		tf->modelFilepath = std::wstring(outLength, L'\0');
-		MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, modelFilepath_rawPtr, -1,
-				    tf->modelFilepath.data(), outLength);
+			int outLength = MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED,
+							    modelFilepath_rawPtr, -1, nullptr, 0);
+			request->modelFilepath = std::wstring(outLength, L'\0');
+			MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, modelFilepath_rawPtr, -1,
+					    request->modelFilepath.data(), outLength);
 #else
-		tf->modelFilepath = std::string(modelFilepath_rawPtr);
+			request->modelFilepath = std::string(modelFilepath_rawPtr);
 #endif
-		bfree(modelFilepath_rawPtr);
-
-		// Re-initialize model if it's not already the selected one or switching inference device
-		tf->useGPU = newUseGpu;
-		tf->numThreads = newNumThreads;
-		tf->modelSize = newModelSize;
-
-		// parameters
-		int onnxruntime_device_id_ = 0;
-		bool onnxruntime_use_parallel_ = true;
-		float nms_th_ = 0.45f;
-		int num_classes_ = (int)edgeyolo_cpp::COCO_CLASSES.size();
-		tf->classNames = edgeyolo_cpp::COCO_CLASSES;
+			bfree(modelFilepath_rawPtr);
+			request->modelSize = newModelSize;
+			request->useGPU = newUseGpu;
+			request->numThreads = newNumThreads;
+			request->numClasses = (int)edgeyolo_cpp::COCO_CLASSES.size();
+			request->classNames = edgeyolo_cpp::COCO_CLASSES;
+		}
 
 		// If this is an external model - look for the config JSON file
-		if (tf->modelSize == EXTERNAL_MODEL_SIZE) {
+		if (request && request->modelSize == EXTERNAL_MODEL_SIZE) {
 #ifdef _WIN32
-			std::wstring labelsFilepath = tf->modelFilepath;
+			std::wstring labelsFilepath = request->modelFilepath;
 			labelsFilepath.replace(labelsFilepath.find(L".onnx"), 5, L".json");
 #else
-			std::string labelsFilepath = tf->modelFilepath;
+			std::string labelsFilepath = request->modelFilepath;
 			labelsFilepath.replace(labelsFilepath.find(".onnx"), 5, ".json");
 #endif
 			std::ifstream labelsFile(labelsFilepath);
@@ -609,59 +778,63 @@ void detect_filter_update(void *data, obs_data_t *settings)
 				labelsFile >> j;
 				if (j.contains("names")) {
 					std::vector<std::string> labels = j["names"];
-					num_classes_ = (int)labels.size();
-					tf->classNames = labels;
+					request->numClasses = (int)labels.size();
+					request->classNames = labels;
 				} else {
 					obs_log(LOG_ERROR,
 						"JSON file does not contain 'labels' field");
-					tf->isDisabled = true;
-					tf->onnxruntimemodel.reset();
-					return;
+					obs_data_set_string(
+						settings, "error",
+						"JSON file does not contain 'names' field");
+					request.reset();
 				}
 			} else {
 				obs_log(LOG_ERROR, "Failed to open JSON file: %s",
 					labelsFilepath.c_str());
-				tf->isDisabled = true;
-				tf->onnxruntimemodel.reset();
-				return;
+				obs_data_set_string(settings, "error", "JSON file not found");
+				request.reset();
 			}
-		} else if (tf->modelSize == FACE_DETECT_MODEL_SIZE) {
-			num_classes_ = 1;
-			tf->classNames = yunet::FACE_CLASSES;
+		} else if (request && request->modelSize == FACE_DETECT_MODEL_SIZE) {
+			request->numClasses = 1;
+			request->classNames = yunet::FACE_CLASSES;
 		}
 
-		// Load model
-		try {
-			if (tf->onnxruntimemodel) {
-				tf->onnxruntimemodel.reset();
-			}
-			if (tf->modelSize == FACE_DETECT_MODEL_SIZE) {
-				tf->onnxruntimemodel = std::make_unique<yunet::YuNetONNX>(
-					tf->modelFilepath, tf->numThreads, 50, tf->numThreads,
-					tf->useGPU, onnxruntime_device_id_,
-					onnxruntime_use_parallel_, nms_th_, tf->conf_threshold);
-			} else {
-				tf->onnxruntimemodel =
-					std::make_unique<edgeyolo_cpp::EdgeYOLOONNXRuntime>(
-						tf->modelFilepath, tf->numThreads, num_classes_,
-						tf->numThreads, tf->useGPU, onnxruntime_device_id_,
-						onnxruntime_use_parallel_, nms_th_,
-						tf->conf_threshold);
-			}
-			// clear error message
-			obs_data_set_string(settings, "error", "");
-		} catch (const std::exception &e) {
-			obs_log(LOG_ERROR, "Failed to load model: %s", e.what());
-			// disable filter
-			tf->isDisabled = true;
-			tf->onnxruntimemodel.reset();
-			return;
+		if (request) {
+			tf->useGPU = newUseGpu;
+			tf->numThreads = newNumThreads;
+			tf->modelSize = newModelSize;
+			tf->modelFilepath = request->modelFilepath;
+
+			// hand the request to the loader, replacing one that did not start yet
+			std::lock_guard<std::mutex> lock(tf->loaderLock);
+			request->generation = ++tf->modelGeneration;
+			tf->pendingLoad = std::move(request);
+			tf->loaderCondition.notify_one();
 		}
 	}
 
-	// update threshold on edgeyolo
-	if (tf->onnxruntimemodel) {
-		tf->onnxruntimemodel->setBBoxConfThresh(tf->conf_threshold);
+	// hand the threshold, NMS and detection query to the worker, which applies them before
+	// its next model run. The model mutex is held for a whole run, so do not wait for it here.
+	tf->objectCategoryNames = objectCategoryNames;
+	model_config config;
+	if (tf->sortTracking && tf->trackerMode == "bytetrack") {
+		// the tracker also needs the detections below the threshold
+		config.bboxConfThreshold = std::min(tf->conf_threshold, tf->trackLowThreshold);
+	} else {
+		config.bboxConfThreshold = tf->conf_threshold;
+	}
+	config.batchMaxSize = tf->batchMaxSize;
+	config.batchMaxWait = tf->batchMaxWait;
+	config.nmsMode = tf->nmsMode;
+	config.objectCategory = tf->objectCategory;
+	config.objectCategoryNames = objectCategoryNames;
+	config.minArea = (float)tf->minAreaThreshold;
+	config.maxArea = (float)tf->maxAreaThreshold;
+	config.topK = (size_t)tf->maxDetections;
+	{
+		std::lock_guard<std::mutex> lock(tf->configLock);
+		tf->pendingConfig = std::move(config);
+		tf->configPending = true;
 	}
 
 	if (reinitialize) {
@@ -674,8 +847,12 @@ void detect_filter_update(void *data, obs_data_t *settings)
 		obs_log(LOG_INFO, "  Model Size: %s", tf->modelSize.c_str());
 		obs_log(LOG_INFO, "  Preview: %s", tf->preview ? "true" : "false");
 		obs_log(LOG_INFO, "  Threshold: %.2f", tf->conf_threshold);
+		obs_log(LOG_INFO, "  Tracker Mode: %s", tf->trackerMode.c_str());
 		obs_log(LOG_INFO, "  Object Category: %s",
 			obs_data_get_string(settings, "object_category"));
+		for (const std::string &name : tf->objectCategoryNames) {
+			obs_log(LOG_INFO, "  Object Category: %s", name.c_str());
+		}
 		obs_log(LOG_INFO, "  Masking Enabled: %s",
 			obs_data_get_bool(settings, "masking_group") ? "true" : "false");
 		obs_log(LOG_INFO, "  Masking Type: %s",
@@ -718,6 +895,373 @@ void detect_filter_deactivate(void *data)
 
 /**                   FILTER CORE                     */
 
+/**
+  * @brief Minimal time between two model runs
+  *
+  * The larger of the interval for the maximal inference rate and the interval that keeps the
+  * measured model run time within the inference time budget.
+*/
+static double detect_filter_inference_interval_ms(const struct detect_filter *tf)
+{
+	double intervalMs = 0.0;
+	if (tf->maxInferenceFps > 0) {
+		intervalMs = 1000.0 / (double)tf->maxInferenceFps;
+	}
+	if (tf->inferenceBudget > 0) {
+		intervalMs = std::max(intervalMs, tf->inferenceLatencyMs * 100.0 /
+							  (double)tf->inferenceBudget);
+	}
+	return intervalMs;
+}
+
+/**
+  * @brief Detect objects in a captured frame and publish the results
+  *
+  * The image holds `region` of the source frame, possibly scaled down on the GPU. The
+  * detections are mapped back to source frame coordinates for the masking, the zoom and the
+  * export.
+*/
+static void detect_filter_process_frame(struct detect_filter *tf, const cv::Mat &imageBGRA,
+					const cv::Rect &region, const cv::Size &sourceSize)
+{
+	const float scaleX = (float)region.width / (float)imageBGRA.cols;
+	const float scaleY = (float)region.height / (float)imageBGRA.rows;
+	const cv::Rect cropRect = getCropRect(tf, (uint32_t)sourceSize.width,
+					      (uint32_t)sourceSize.height);
+	// the crop in image coordinates, the whole image when only the crop was read back
+	const cv::Rect imageCrop =
+		cv::Rect((int)std::lround((float)(cropRect.x - region.x) / scaleX),
+			 (int)std::lround((float)(cropRect.y - region.y) / scaleY),
+			 (int)std::lround((float)cropRect.width / scaleX),
+			 (int)std::lround((float)cropRect.height / scaleY)) &
+		cv::Rect(0, 0, imageBGRA.cols, imageBGRA.rows);
+	if (imageCrop.empty()) {
+		// the crop changed since the frame was read back
+		return;
+	}
+	// the model preprocessing reads the BGRA crop directly, no color conversion or copy
+	const cv::Mat inferenceFrame = imageBGRA(imageCrop);
+
+	std::vector<Object> objects;
+	// detections below the confidence threshold, only produced for ByteTrack tracking
+	std::vector<Object> lowObjects;
+
+	// run the model only as often as the rate limit allows, and only on changed frames
+	const auto now = std::chrono::steady_clock::now();
+	const double sinceLastRunMs =
+		std::chrono::duration<double, std::milli>(now - tf->lastInferenceTime).count();
+	const bool due = sinceLastRunMs >= detect_filter_inference_interval_ms(tf);
+	// the motion gate only sees the frames the rate limit lets through, its skip limit counts
+	// model runs
+	const bool gateSkip = due && tf->motionGating &&
+			      !motion_gate_should_run(tf->motionGate, inferenceFrame,
+						      tf->motionThreshold,
+						      (uint32_t)tf->motionMaxSkip);
+	const bool runModel = due && !gateSkip;
+
+	if (runModel) {
+		tf->lastInferenceTime = now;
+		try {
+			std::unique_lock<std::mutex> lock(tf->modelMutex);
+			if (!tf->onnxruntimemodel) {
+				return;
+			}
+			if (detect_filter_take_config(tf)) {
+				detect_filter_configure_model(tf, *tf->onnxruntimemodel,
+							      tf->modelInfo->classNames);
+			}
+			// the size limits are in source pixels, the image may be scaled down
+			const DetectionQuery query = tf->detectionQuery.scaled(1.0f / scaleX);
+			if (tf->tiledInference) {
+				objects = tiled_inference(*tf->onnxruntimemodel, inferenceFrame,
+							  tf->tileOverlap, tf->tileFullFrame,
+							  query);
+			} else {
+				objects = tf->onnxruntimemodel->inference(inferenceFrame, query);
+			}
+			tf->lastModelInfo = tf->modelInfo;
+			const double runMs = std::chrono::duration<double, std::milli>(
+						     std::chrono::steady_clock::now() - now)
+						     .count();
+			// smooth the run time so a single slow run does not stall the rate
+			if (tf->inferenceLatencyMs > 0.0) {
+				tf->inferenceLatencyMs = 0.9 * tf->inferenceLatencyMs + 0.1 * runMs;
+			} else {
+				tf->inferenceLatencyMs = runMs;
+			}
+			tf->stats.inferenceRuns++;
+			tf->stats.inferenceTotalUs += (uint64_t)(runMs * 1000.0);
+		} catch (const Ort::Exception &e) {
+			obs_log(LOG_ERROR, "ONNXRuntime Exception: %s", e.what());
+		} catch (const std::exception &e) {
+			obs_log(LOG_ERROR, "%s", e.what());
+		}
+
+		// map the detected objects to the source frame
+		for (Object &obj : objects) {
+			obj.rect.x = (obj.rect.x + (float)imageCrop.x) * scaleX + (float)region.x;
+			obj.rect.y = (obj.rect.y + (float)imageCrop.y) * scaleY + (float)region.y;
+			obj.rect.width *= scaleX;
+			obj.rect.height *= scaleY;
+		}
+		const float confThreshold = tf->conf_threshold;
+		auto low = std::stable_partition(objects.begin(), objects.end(),
+						 [confThreshold](const Object &obj) {
+							 return obj.prob > confThreshold;
+						 });
+		lowObjects.assign(low, objects.end());
+		objects.erase(low, objects.end());
+		tf->lastDetections = objects;
+	} else {
+		if (gateSkip) {
+			tf->stats.gateSkipped++;
+		} else {
+			tf->stats.framesSkipped++;
+		}
+		if (!tf->sortTracking) {
+			objects = tf->lastDetections;
+		}
+	}
+
+	if (tf->sortTracking) {
+		// between model runs the tracks move on with their Kalman state
+		objects = runModel ? tf->tracker.update(objects, lowObjects)
+				   : tf->tracker.predict();
+	}
+
+	if (!tf->showUnseenObjects) {
+		objects.erase(
+			std::remove_if(objects.begin(), objects.end(),
+				       [](const Object &obj) { return obj.unseenFrames > 0; }),
+			objects.end());
+	}
+
+	// the label of the first object after tracking, as shown, goes to the detected object
+	// text input
+	const int detectedLabel = objects.empty() ? -1 : objects[0].label;
+
+	if (!tf->saveDetectionsPath.empty()) {
+		std::ofstream detectionsFile(tf->saveDetectionsPath);
+		if (detectionsFile.is_open()) {
+			nlohmann::json j;
+			for (const Object &obj : objects) {
+				nlohmann::json obj_json;
+				obj_json["label"] = obj.label;
+				obj_json["confidence"] = obj.prob;
+				obj_json["rect"] = {{"x", obj.rect.x},
+						    {"y", obj.rect.y},
+						    {"width", obj.rect.width},
+						    {"height", obj.rect.height}};
+				obj_json["id"] = obj.id;
+				j.push_back(obj_json);
+			}
+			detectionsFile << j.dump(4);
+			detectionsFile.close();
+		} else {
+			obs_log(LOG_ERROR, "Failed to open file for writing detections: %s",
+				tf->saveDetectionsPath.c_str());
+		}
+	}
+
+	// publish the results for the video tick and render, every field of the recycled buffer
+	// is rewritten and its object list keeps its memory
+	detect_output &output = tf->output.writeBuffer();
+
+	output.objects = objects;
+	output.frameSize = sourceSize;
+	output.detectedLabel = detectedLabel;
+	output.model = tf->lastModelInfo;
+	tf->output.publish();
+}
+
+/**
+  * @brief The detection worker thread
+  *
+  * Waits for frames in the input mailbox and runs inference and tracking on them, so the
+  * OBS graphics thread never waits on the model. Only the latest frame is kept in the
+  * input triple buffer, frames that were replaced before the worker picked them up are
+  * dropped.
+*/
+static void detect_filter_worker(struct detect_filter *tf)
+{
+	obs_log(LOG_INFO, "Detect worker started");
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(tf->inputWakeLock);
+			tf->inputCondition.wait(
+				lock, [tf] { return tf->workerStop || tf->input.hasNew(); });
+			if (tf->workerStop) {
+				break;
+			}
+		}
+		// take the latest frame, the capture keeps filling the other buffers meanwhile
+		tf->input.update();
+		const captured_frame &frame = tf->input.readBuffer();
+
+		if (tf->isDisabled || frame.imageBGRA.empty()) {
+			continue;
+		}
+
+		detect_filter_process_frame(tf, frame.imageBGRA, frame.region, frame.sourceSize);
+
+		const uint64_t latencyUs =
+			(uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - frame.timestamp)
+				.count();
+		tf->stats.framesProcessed++;
+		tf->stats.workerLatencyTotalUs += latencyUs;
+		uint64_t maxUs = tf->stats.workerLatencyMaxUs;
+		while (latencyUs > maxUs &&
+		       !tf->stats.workerLatencyMaxUs.compare_exchange_weak(maxUs, latencyUs)) {
+		}
+	}
+
+	obs_log(LOG_INFO, "Detect worker stopped");
+}
+
+static void detect_filter_set_error(struct detect_filter *tf, const char *error)
+{
+	obs_data_t *source_settings = obs_source_get_settings(tf->source);
+	obs_data_set_string(source_settings, "error", error);
+	obs_data_release(source_settings);
+}
+
+static std::unique_ptr<ONNXRuntimeModel>
+detect_filter_create_model(const struct model_load_request &request)
+{
+	// parameters
+	int onnxruntime_device_id_ = 0;
+	bool onnxruntime_use_parallel_ = true;
+	float nms_th_ = 0.45f;
+	// the confidence threshold is set when the model is swapped in
+	float conf_th_ = 0.5f;
+
+	std::unique_ptr<ONNXRuntimeModel> model;
+	if (request.modelSize == FACE_DETECT_MODEL_SIZE) {
+		model = std::make_unique<yunet::YuNetONNX>(
+			request.modelFilepath, request.numThreads, 50, request.numThreads,
+			request.useGPU, onnxruntime_device_id_, onnxruntime_use_parallel_, nms_th_,
+			conf_th_);
+	} else {
+		model = std::make_unique<edgeyolo_cpp::EdgeYOLOONNXRuntime>(
+			request.modelFilepath, request.numThreads, request.numClasses,
+			request.numThreads, request.useGPU, onnxruntime_device_id_,
+			onnxruntime_use_parallel_, nms_th_, conf_th_);
+	}
+
+	// warm up: the first run allocates the ORT buffers and initializes the execution
+	// provider, do not let the first real frame pay for it
+	model->inference(cv::Mat(model->inputSize(), CV_8UC3, cv::Scalar(114, 114, 114)));
+	return model;
+}
+
+/**
+  * @brief The background model loader thread
+  *
+  * Builds and warms up the requested model while the current model keeps serving the
+  * detection worker, then swaps it in under the model mutex. A model that was superseded by a
+  * newer request while loading is dropped. Load failures are reported in the error setting
+  * and leave the current model in place.
+*/
+static void detect_filter_loader(struct detect_filter *tf)
+{
+	while (true) {
+		std::unique_ptr<model_load_request> request;
+		{
+			std::unique_lock<std::mutex> lock(tf->loaderLock);
+			tf->loaderCondition.wait(
+				lock, [tf] { return tf->loaderStop || tf->pendingLoad; });
+			if (tf->loaderStop) {
+				break;
+			}
+			request = std::move(tf->pendingLoad);
+		}
+
+		obs_log(LOG_INFO, "Loading model %s (%s) in the background",
+			request->modelSize.c_str(), request->useGPU.c_str());
+		const auto loadStart = std::chrono::steady_clock::now();
+		std::unique_ptr<ONNXRuntimeModel> model;
+		try {
+			model = detect_filter_create_model(*request);
+		} catch (const std::exception &e) {
+			obs_log(LOG_ERROR, "Failed to load model: %s", e.what());
+			detect_filter_set_error(tf, e.what());
+			continue;
+		}
+		const double loadMs = std::chrono::duration<double, std::milli>(
+					      std::chrono::steady_clock::now() - loadStart)
+					      .count();
+
+		{
+			std::lock_guard<std::mutex> lock(tf->loaderLock);
+			if (request->generation != tf->modelGeneration) {
+				obs_log(LOG_INFO, "Dropping model superseded while loading");
+				continue;
+			}
+		}
+
+		// the render thread reads back frames scaled down to the input size
+		auto info = std::make_shared<model_info>();
+		info->classNames = std::move(request->classNames);
+		info->inputSize = model->inputSize();
+
+		{
+			std::lock_guard<std::mutex> lock(tf->modelMutex);
+			detect_filter_take_config(tf);
+			detect_filter_configure_model(tf, *model, info->classNames);
+			std::swap(tf->onnxruntimemodel, model);
+			tf->modelInfo = std::move(info);
+		}
+		tf->modelReady = true;
+		// release the previous model outside of the model mutex
+		model.reset();
+
+		obs_log(LOG_INFO, "Model %s ready after %.0f ms", request->modelSize.c_str(),
+			loadMs);
+		detect_filter_set_error(tf, "");
+	}
+}
+
+static void log_detect_stats(struct detect_filter *tf, float elapsed)
+{
+	const uint64_t submitted = tf->stats.framesSubmitted.exchange(0);
+	const uint64_t dropped = tf->stats.framesDropped.exchange(0);
+	const uint64_t processed = tf->stats.framesProcessed.exchange(0);
+	const uint64_t skipped = tf->stats.framesSkipped.exchange(0);
+	const uint64_t gateSkipped = tf->stats.gateSkipped.exchange(0);
+	const uint64_t inferenceRuns = tf->stats.inferenceRuns.exchange(0);
+	const uint64_t inferenceTotalUs = tf->stats.inferenceTotalUs.exchange(0);
+	const uint64_t latencyTotalUs = tf->stats.workerLatencyTotalUs.exchange(0);
+	const uint64_t latencyMaxUs = tf->stats.workerLatencyMaxUs.exchange(0);
+	const uint64_t gpuAllocations = tf->stats.gpuAllocations.exchange(0);
+
+	obs_log(LOG_INFO,
+		"Detect stats (%s, last %.0fs): frames submitted %llu, dropped %llu, "
+		"processed %llu, inference skipped by the rate limit %.0f%%, by the motion gate "
+		"%.0f%%, inference avg %.1f ms, worker latency avg %.1f ms, max %.1f ms",
+		obs_source_get_name(tf->source), elapsed, (unsigned long long)submitted,
+		(unsigned long long)dropped, (unsigned long long)processed,
+		processed > 0 ? 100.0 * (double)skipped / (double)processed : 0.0,
+		processed > 0 ? 100.0 * (double)gateSkipped / (double)processed : 0.0,
+		inferenceRuns > 0 ? (double)inferenceTotalUs / (double)inferenceRuns / 1000.0
+				  : 0.0,
+		processed > 0 ? (double)latencyTotalUs / (double)processed / 1000.0 : 0.0,
+		(double)latencyMaxUs / 1000.0);
+	// frame buffers are recycled, new allocations are only expected after a size change
+	const FramePool::Stats pool = tf->framePool.takeStats();
+	obs_log(LOG_INFO, "Detect frame buffers (%s): acquired %llu, allocated %llu (%.1f MB)",
+		obs_source_get_name(tf->source), (unsigned long long)pool.acquired,
+		(unsigned long long)pool.allocations,
+		(double)pool.allocated_bytes / (1024.0 * 1024.0));
+	// the render textures are persistent as well, they are only reallocated on a resize
+	obs_log(LOG_INFO, "Detect GPU allocations (%s): %llu, %.2f/s",
+		obs_source_get_name(tf->source), (unsigned long long)gpuAllocations,
+		elapsed > 0.0f ? (double)gpuAllocations / (double)elapsed : 0.0);
+	// the model sessions are shared between filters, show how many use each of them
+	ModelRegistry::instance().logUsage();
+}
+
 void *detect_filter_create(obs_data_t *settings, obs_source_t *source)
 {
 	obs_log(LOG_INFO, "Detect filter created");
@@ -726,12 +1270,20 @@ void *detect_filter_create(obs_data_t *settings, obs_source_t *source)
 
 	tf->source = source;
 	tf->texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
+	tf->readbackTexrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
+	tf->maskTexrender = gs_texrender_create(GS_R8, GS_ZS_NONE);
+	tf->pixelateTexrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
+	for (gs_texrender_t *&level : tf->blurPyramid) {
+		level = gs_texrender_create(GS_RGBA16F, GS_ZS_NONE);
+	}
+	tf->blurTexrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
 	tf->lastDetectedObjectId = -1;
 
 	std::vector<std::tuple<const char *, gs_effect_t **>> effects = {
 		{KAWASE_BLUR_EFFECT_PATH, &tf->kawaseBlurEffect},
 		{MASKING_EFFECT_PATH, &tf->maskingEffect},
 		{PIXELATE_EFFECT_PATH, &tf->pixelateEffect},
+		{OVERLAY_EFFECT_PATH, &tf->overlayEffect},
 	};
 
 	for (auto [effectPath, effect] : effects) {
@@ -754,6 +1306,9 @@ void *detect_filter_create(obs_data_t *settings, obs_source_t *source)
 
 	detect_filter_update(tf, settings);
 
+	tf->workerThread = std::thread(detect_filter_worker, tf);
+	tf->loaderThread = std::thread(detect_filter_loader, tf);
+
 	return tf;
 }
 
@@ -766,13 +1321,45 @@ void detect_filter_destroy(void *data)
 	if (tf) {
 		tf->isDisabled = true;
 
+		// stop the loader, this waits for a model that is currently being built
+		{
+			std::lock_guard<std::mutex> lock(tf->loaderLock);
+			tf->loaderStop = true;
+		}
+		tf->loaderCondition.notify_all();
+		if (tf->loaderThread.joinable()) {
+			tf->loaderThread.join();
+		}
+
+		// stop the detection worker before tearing down the model and the graphics
+		{
+			std::lock_guard<std::mutex> lock(tf->inputWakeLock);
+			tf->workerStop = true;
+		}
+		tf->inputCondition.notify_all();
+		if (tf->workerThread.joinable()) {
+			tf->workerThread.join();
+		}
+
 		obs_enter_graphics();
 		gs_texrender_destroy(tf->texrender);
-		if (tf->stagesurface) {
-			gs_stagesurface_destroy(tf->stagesurface);
+		gs_texrender_destroy(tf->readbackTexrender);
+		gs_texrender_destroy(tf->maskTexrender);
+		gs_texrender_destroy(tf->pixelateTexrender);
+		for (gs_texrender_t *level : tf->blurPyramid) {
+			gs_texrender_destroy(level);
+		}
+		gs_texrender_destroy(tf->blurTexrender);
+		for (stage_slot &slot : tf->stageSlots) {
+			if (slot.surface) {
+				gs_stagesurface_destroy(slot.surface);
+			}
 		}
 		gs_effect_destroy(tf->kawaseBlurEffect);
 		gs_effect_destroy(tf->maskingEffect);
+		gs_effect_destroy(tf->pixelateEffect);
+		gs_effect_destroy(tf->overlayEffect);
+		tf->previewOverlay.destroy();
 		obs_leave_graphics();
 		tf->~detect_filter();
 		bfree(tf);
@@ -781,11 +1368,9 @@ void detect_filter_destroy(void *data)
 
 void detect_filter_video_tick(void *data, float seconds)
 {
-	UNUSED_PARAMETER(seconds);
-
 	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
 
-	if (tf->isDisabled || !tf->onnxruntimemodel) {
+	if (tf->isDisabled || !tf->modelReady) {
 		return;
 	}
 
@@ -793,161 +1378,44 @@ void detect_filter_video_tick(void *data, float seconds)
 		return;
 	}
 
-	cv::Mat imageBGRA;
-	{
-		std::unique_lock<std::mutex> lock(tf->inputBGRALock, std::try_to_lock);
-		if (!lock.owns_lock()) {
-			// No data to process
-			return;
+	if (tf->logStats) {
+		tf->logStatsElapsed += seconds;
+		if (tf->logStatsElapsed >= 10.0f) {
+			log_detect_stats(tf, tf->logStatsElapsed);
+			tf->logStatsElapsed = 0.0f;
 		}
-		if (tf->inputBGRA.empty()) {
-			// No data to process
-			return;
-		}
-		imageBGRA = tf->inputBGRA.clone();
-	}
-
-	cv::Mat inferenceFrame;
-
-	cv::Rect cropRect(0, 0, imageBGRA.cols, imageBGRA.rows);
-	if (tf->crop_enabled) {
-		cropRect = cv::Rect(tf->crop_left, tf->crop_top,
-				    imageBGRA.cols - tf->crop_left - tf->crop_right,
-				    imageBGRA.rows - tf->crop_top - tf->crop_bottom);
-		cv::cvtColor(imageBGRA(cropRect), inferenceFrame, cv::COLOR_BGRA2BGR);
-	} else {
-		cv::cvtColor(imageBGRA, inferenceFrame, cv::COLOR_BGRA2BGR);
-	}
-
-	std::vector<Object> objects;
-
-	try {
-		std::unique_lock<std::mutex> lock(tf->modelMutex);
-		objects = tf->onnxruntimemodel->inference(inferenceFrame);
-	} catch (const Ort::Exception &e) {
-		obs_log(LOG_ERROR, "ONNXRuntime Exception: %s", e.what());
-	} catch (const std::exception &e) {
-		obs_log(LOG_ERROR, "%s", e.what());
 	}
 
-	if (tf->crop_enabled) {
-		// translate the detected objects to the original frame
-		for (Object &obj : objects) {
-			obj.rect.x += (float)cropRect.x;
-			obj.rect.y += (float)cropRect.y;
-		}
+	// pick up the latest results of the detection worker, this never waits on the model. The
+	// render of this frame uses the same results.
+	tf->output.update();
+	const detect_output &output = tf->output.readBuffer();
+	if (output.frameSize.empty()) {
+		// No results yet
+		return;
 	}
+	const std::vector<Object> &objects = output.objects;
+	const cv::Size frameSize = output.frameSize;
+	const int detectedLabel = output.detectedLabel;
 
 	// update the detected object text input
-	if (objects.size() > 0) {
-		if (tf->lastDetectedObjectId != objects[0].label) {
-			tf->lastDetectedObjectId = objects[0].label;
-			// get source settings
-			obs_data_t *source_settings = obs_source_get_settings(tf->source);
-			obs_data_set_string(source_settings, "detected_object",
-					    tf->classNames[objects[0].label].c_str());
-			// release the source settings
-			obs_data_release(source_settings);
-		}
-	} else {
-		if (tf->lastDetectedObjectId != -1) {
-			tf->lastDetectedObjectId = -1;
-			// get source settings
-			obs_data_t *source_settings = obs_source_get_settings(tf->source);
-			obs_data_set_string(source_settings, "detected_object", "");
-			// release the source settings
-			obs_data_release(source_settings);
+	if (tf->lastDetectedObjectId != detectedLabel) {
+		tf->lastDetectedObjectId = detectedLabel;
+		const char *detectedName = "";
+		if (output.model && detectedLabel >= 0 &&
+		    (size_t)detectedLabel < output.model->classNames.size()) {
+			detectedName = output.model->classNames[(size_t)detectedLabel].c_str();
 		}
-	}
-
-	if (tf->minAreaThreshold > 0) {
-		std::vector<Object> filtered_objects;
-		for (const Object &obj : objects) {
-			if (obj.rect.area() > (float)tf->minAreaThreshold) {
-				filtered_objects.push_back(obj);
-			}
-		}
-		objects = filtered_objects;
-	}
-
-	if (tf->objectCategory != -1) {
-		std::vector<Object> filtered_objects;
-		for (const Object &obj : objects) {
-			if (obj.label == tf->objectCategory) {
-				filtered_objects.push_back(obj);
-			}
-		}
-		objects = filtered_objects;
-	}
-
-	if (tf->sortTracking) {
-		objects = tf->tracker.update(objects);
-	}
-
-	if (!tf->showUnseenObjects) {
-		objects.erase(
-			std::remove_if(objects.begin(), objects.end(),
-				       [](const Object &obj) { return obj.unseenFrames > 0; }),
-			objects.end());
-	}
-
-	if (!tf->saveDetectionsPath.empty()) {
-		std::ofstream detectionsFile(tf->saveDetectionsPath);
-		if (detectionsFile.is_open()) {
-			nlohmann::json j;
-			for (const Object &obj : objects) {
-				nlohmann::json obj_json;
-				obj_json["label"] = obj.label;
-				obj_json["confidence"] = obj.prob;
-				obj_json["rect"] = {{"x", obj.rect.x},
-						    {"y", obj.rect.y},
-						    {"width", obj.rect.width},
-						    {"height", obj.rect.height}};
-				obj_json["id"] = obj.id;
-				j.push_back(obj_json);
-			}
-			detectionsFile << j.dump(4);
-			detectionsFile.close();
-		} else {
-			obs_log(LOG_ERROR, "Failed to open file for writing detections: %s",
-				tf->saveDetectionsPath.c_str());
-		}
-	}
-
-	if (tf->preview || tf->maskingEnabled) {
-		cv::Mat frame;
-		cv::cvtColor(imageBGRA, frame, cv::COLOR_BGRA2BGR);
-
-		if (tf->preview && tf->crop_enabled) {
-			// draw the crop rectangle on the frame in a dashed line
-			drawDashedRectangle(frame, cropRect, cv::Scalar(0, 255, 0), 5, 8, 15);
-		}
-		if (tf->preview && objects.size() > 0) {
-			draw_objects(frame, objects, tf->classNames);
-		}
-		if (tf->maskingEnabled) {
-			cv::Mat mask = cv::Mat::zeros(frame.size(), CV_8UC1);
-			for (const Object &obj : objects) {
-				cv::rectangle(mask, obj.rect, cv::Scalar(255), -1);
-			}
-			std::lock_guard<std::mutex> lock(tf->outputLock);
-			mask.copyTo(tf->outputMask);
-
-			if (tf->maskingDilateIterations > 0) {
-				cv::Mat dilatedMask;
-				cv::dilate(tf->outputMask, dilatedMask, cv::Mat(),
-					   cv::Point(-1, -1), tf->maskingDilateIterations);
-				dilatedMask.copyTo(tf->outputMask);
-			}
-		}
-
-		std::lock_guard<std::mutex> lock(tf->outputLock);
-		cv::cvtColor(frame, tf->outputPreviewBGRA, cv::COLOR_BGR2BGRA);
+		// get source settings
+		obs_data_t *source_settings = obs_source_get_settings(tf->source);
+		obs_data_set_string(source_settings, "detected_object", detectedName);
+		// release the source settings
+		obs_data_release(source_settings);
 	}
 
 	if (tf->trackingEnabled && tf->trackingFilter) {
-		const int width = imageBGRA.cols;
-		const int height = imageBGRA.rows;
+		const int width = frameSize.width;
+		const int height = frameSize.height;
 
 		cv::Rect2f boundingBox = cv::Rect2f(0, 0, (float)width, (float)height);
 		// get location of the objects
@@ -1052,7 +1520,7 @@ void detect_filter_video_render(void *data, gs_effect_t *_effect)
 
 	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
 
-	if (tf->isDisabled || !tf->onnxruntimemodel) {
+	if (tf->isDisabled || !tf->modelReady) {
 		if (tf->source) {
 			obs_source_skip_video_filter(tf->source);
 		}
@@ -1069,51 +1537,47 @@ void detect_filter_video_render(void *data, gs_effect_t *_effect)
 
 	// if preview is enabled, render the image
 	if (tf->preview || tf->maskingEnabled) {
-		cv::Mat outputBGRA, outputMask;
-		{
-			// lock the outputLock mutex
-			std::lock_guard<std::mutex> lock(tf->outputLock);
-			if (tf->outputPreviewBGRA.empty()) {
-				obs_log(LOG_ERROR, "Preview image is empty");
-				if (tf->source) {
-					obs_source_skip_video_filter(tf->source);
-				}
-				return;
+		// the mask is rasterized on the GPU from the published boxes. Blur and pixelate
+		// only process the region of the frame under the mask and are blended over the
+		// frame by the mask. The preview boxes and labels are drawn over the result.
+		const detect_output &output = tf->output.readBuffer();
+		const cv::Size size((int)width, (int)height);
+		if (tf->maskingEnabled && output.frameSize != size) {
+			if (tf->source) {
+				obs_source_skip_video_filter(tf->source);
 			}
-			if ((uint32_t)tf->outputPreviewBGRA.cols != width ||
-			    (uint32_t)tf->outputPreviewBGRA.rows != height) {
-				if (tf->source) {
-					obs_source_skip_video_filter(tf->source);
-				}
-				return;
-			}
-			outputBGRA = tf->outputPreviewBGRA.clone();
-			outputMask = tf->outputMask.clone();
+			return;
 		}
-
-		gs_texture_t *tex = gs_texture_create(width, height, GS_BGRA, 1,
-						      (const uint8_t **)&outputBGRA.data, 0);
 		gs_texture_t *maskTexture = nullptr;
+		cv::Rect maskRegion;
+		if (tf->maskingEnabled) {
+			maskRegion = get_mask_region(tf, width, height, output.objects);
+			maskTexture =
+				render_box_mask(tf, width, height, output.objects, maskRegion);
+		}
 		std::string technique_name = "Draw";
 		gs_eparam_t *imageParam = gs_effect_get_param_by_name(tf->maskingEffect, "image");
 		gs_eparam_t *maskParam =
 			gs_effect_get_param_by_name(tf->maskingEffect, "focalmask");
+		gs_eparam_t *processedParam =
+			gs_effect_get_param_by_name(tf->maskingEffect, "processed");
 		gs_eparam_t *maskColorParam =
 			gs_effect_get_param_by_name(tf->maskingEffect, "color");
 
 		if (tf->maskingEnabled) {
-			maskTexture = gs_texture_create(width, height, GS_R8, 1,
-							(const uint8_t **)&outputMask.data, 0);
 			gs_effect_set_texture(maskParam, maskTexture);
 			if (tf->maskingType == "output_mask") {
 				technique_name = "DrawMask";
-			} else if (tf->maskingType == "blur") {
-				gs_texture_destroy(tex);
-				tex = blur_image(tf, width, height, maskTexture);
-			} else if (tf->maskingType == "pixelate") {
-				gs_texture_destroy(tex);
-				tex = pixelate_image(tf, width, height, maskTexture,
-						     (float)tf->maskingBlurRadius);
+			} else if (tf->maskingType == "blur" && !maskRegion.empty()) {
+				technique_name = "DrawProcessed";
+				gs_effect_set_texture(processedParam,
+						      blur_image(tf, width, height, maskTexture,
+								 maskRegion));
+			} else if (tf->maskingType == "pixelate" && !maskRegion.empty()) {
+				technique_name = "DrawProcessed";
+				gs_effect_set_texture(processedParam,
+						      pixelate_image(tf, width, height, maskRegion,
+								     (float)tf->maskingBlurRadius));
 			} else if (tf->maskingType == "transparent") {
 				technique_name = "DrawSolidColor";
 				gs_effect_set_color(maskColorParam, 0);
@@ -1123,14 +1587,23 @@ void detect_filter_video_render(void *data, gs_effect_t *_effect)
 			}
 		}
 
-		gs_effect_set_texture(imageParam, tex);
+		gs_texture_t *image = gs_texrender_get_texture(tf->texrender);
+		gs_effect_set_texture(imageParam, image);
 
 		while (gs_effect_loop(tf->maskingEffect, technique_name.c_str())) {
-			gs_draw_sprite(tex, 0, 0, 0);
+			gs_draw_sprite(image, 0, 0, 0);
 		}
 
-		gs_texture_destroy(tex);
-		gs_texture_destroy(maskTexture);
+		// the boxes are in the coordinates of the frame they were detected in
+		if (tf->preview && output.frameSize == size) {
+			const std::vector<std::string> noClassNames;
+			tf->previewOverlay.draw(tf->overlayEffect, output.objects,
+						output.model ? output.model->classNames
+							     : noClassNames,
+						tf->crop_enabled ? getCropRect(tf, width, height)
+								 : cv::Rect());
+			tf->stats.gpuAllocations += tf->previewOverlay.takeAllocations();
+		}
 	} else {
 		obs_source_skip_video_filter(tf->source);
 	}
@@ -5,6 +5,7 @@
 #include <opencv2/imgproc.hpp>
 
 #include "ort-model/ONNXRuntimeModel.h"
+#include "decode.h"
 
 namespace edgeyolo_cpp {
 /**
@@ -33,56 +34,43 @@ public:
 protected:
 	int num_array_;
 
+	// proposals of the last decode, reused so their buffer is only allocated once
+	std::vector<Object> proposals_;
+	// 1 for every class allowed by the query and 0 for the others
+	std::vector<uint8_t> allowed_classes_;
+
 	void generate_edgeyolo_proposals(const int num_array, const float *feat_ptr,
-					 const float prob_threshold, std::vector<Object> &objects)
+					 const float prob_threshold, const DetectionQuery &query,
+					 std::vector<Object> &objects)
 	{
-
-		for (int idx = 0; idx < num_array; ++idx) {
-			const int basic_pos = idx * (num_classes_ + 5);
-
-			float box_objectness = feat_ptr[basic_pos + 4];
-			int class_id = 0;
-			float max_class_score = 0.0;
-			for (int class_idx = 0; class_idx < num_classes_; ++class_idx) {
-				float box_cls_score = feat_ptr[basic_pos + 5 + class_idx];
-				float box_prob = box_objectness * box_cls_score;
-				if (box_prob > max_class_score) {
-					class_id = class_idx;
-					max_class_score = box_prob;
+		const uint8_t *allowed_classes = nullptr;
+		if (!query.classes.empty()) {
+			this->allowed_classes_.assign((size_t)this->num_classes_, 0);
+			for (int c : query.classes) {
+				if (c >= 0 && c < this->num_classes_) {
+					this->allowed_classes_[(size_t)c] = 1;
 				}
 			}
-			if (max_class_score > prob_threshold) {
-				float x_center = feat_ptr[basic_pos + 0];
-				float y_center = feat_ptr[basic_pos + 1];
-				float w = feat_ptr[basic_pos + 2];
-				float h = feat_ptr[basic_pos + 3];
-				float x0 = x_center - w * 0.5f;
-				float y0 = y_center - h * 0.5f;
-
-				Object obj;
-				obj.rect.x = x0;
-				obj.rect.y = y0;
-				obj.rect.width = w;
-				obj.rect.height = h;
-				obj.label = class_id;
-				obj.prob = max_class_score;
-				objects.push_back(obj);
-			}
+			allowed_classes = this->allowed_classes_.data();
 		}
+		generate_proposals(feat_ptr, num_array, this->num_classes_, prob_threshold,
+				   allowed_classes, query, objects);
 	}
 
 	void decode_outputs(const float *prob, const int num_array, std::vector<Object> &objects,
 			    const float bbox_conf_thresh, const float scale, const int img_w,
-			    const int img_h)
+			    const int img_h, const DetectionQuery &query)
 	{
 
-		std::vector<Object> proposals;
-		generate_edgeyolo_proposals(num_array, prob, bbox_conf_thresh, proposals);
-
-		qsort_descent_inplace(proposals);
+		// the proposals are in model input coordinates
+		std::vector<Object> &proposals = this->proposals_;
+		generate_edgeyolo_proposals(num_array, prob, bbox_conf_thresh, query.scaled(scale),
+					    proposals);
 
+		NmsOptions options = this->nmsOptions();
+		options.maxDetections = query.topK;
 		std::vector<int> picked;
-		nms_sorted_bboxes(proposals, picked, nms_thresh_);
+		nms(proposals, picked, options);
 
 		int count = (int)(picked.size());
 		objects.clear();
@@ -0,0 +1,99 @@
+#include "decode.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DECODE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DECODE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace edgeyolo_cpp {
+
+int argmax_scores(const float *scores, int count, float &max_score)
+{
+	if (count <= 0) {
+		max_score = 0.0f;
+		return 0;
+	}
+
+	// find the maximum four lanes at a time, then the first index holding it
+	int i = 0;
+	float best = scores[0];
+#if defined(DECODE_SSE2)
+	if (count >= 4) {
+		__m128 vmax = _mm_loadu_ps(scores);
+		for (i = 4; i + 4 <= count; i += 4) {
+			vmax = _mm_max_ps(vmax, _mm_loadu_ps(scores + i));
+		}
+		vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+		vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+		best = _mm_cvtss_f32(vmax);
+	}
+#elif defined(DECODE_NEON)
+	if (count >= 4) {
+		float32x4_t vmax = vld1q_f32(scores);
+		for (i = 4; i + 4 <= count; i += 4) {
+			vmax = vmaxq_f32(vmax, vld1q_f32(scores + i));
+		}
+		best = vmaxvq_f32(vmax);
+	}
+#endif
+	for (; i < count; i++) {
+		if (scores[i] > best) {
+			best = scores[i];
+		}
+	}
+
+	int best_index = 0;
+	while (best_index < count - 1 && scores[best_index] != best) {
+		best_index++;
+	}
+	max_score = best;
+	return best_index;
+}
+
+void generate_proposals(const float *feat_ptr, int num_array, int num_classes,
+			float prob_threshold, const uint8_t *allowed_classes,
+			const DetectionQuery &query, std::vector<Object> &objects)
+{
+	objects.clear();
+	const int row_size = num_classes + 5;
+
+	for (int idx = 0; idx < num_array; ++idx) {
+		const float *row = feat_ptr + (size_t)idx * (size_t)row_size;
+
+		// the class scores can only lower the objectness
+		const float box_objectness = row[4];
+		if (box_objectness <= prob_threshold) {
+			continue;
+		}
+
+		// the label is the best of all classes, a box whose best class is not allowed is
+		// dropped rather than relabelled with the best allowed class
+		float max_class_score;
+		const int class_id = argmax_scores(row + 5, num_classes, max_class_score);
+		const float box_prob = box_objectness * max_class_score;
+		if (box_prob <= prob_threshold ||
+		    (allowed_classes && !allowed_classes[class_id])) {
+			continue;
+		}
+
+		const float x_center = row[0];
+		const float y_center = row[1];
+		const float w = row[2];
+		const float h = row[3];
+		const cv::Rect_<float> rect(x_center - w * 0.5f, y_center - h * 0.5f, w, h);
+		if (!query.allowsBox(rect)) {
+			continue;
+		}
+
+		objects.emplace_back();
+		Object &obj = objects.back();
+		obj.rect = rect;
+		obj.label = class_id;
+		obj.prob = box_prob;
+	}
+}
+
+} // namespace edgeyolo_cpp
@@ -0,0 +1,37 @@
+#ifndef _EdgeYOLO_CPP_DECODE_H
+#define _EdgeYOLO_CPP_DECODE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "ort-model/types.hpp"
+
+namespace edgeyolo_cpp {
+
+/**
+ * @brief Index of the largest score, the first one on ties
+ *
+ * @param max_score  Receives the largest score
+ */
+int argmax_scores(const float *scores, int count, float &max_score);
+
+/**
+ * @brief Decode the EdgeYOLO output rows into proposals
+ *
+ * Each of the `num_array` rows holds cx, cy, w, h, objectness and `num_classes` class scores.
+ * A row becomes a proposal when objectness times its best class score is above
+ * `prob_threshold`. Rows whose objectness alone does not pass the threshold are rejected
+ * without looking at the class scores, which are probabilities of at most 1.
+ *
+ * @param allowed_classes  Nonzero for the allowed classes, or null for all. Rows whose best
+ *                         class is not allowed are dropped.
+ * @param query  Area limits in the coordinates of the output rows
+ * @param objects  Cleared and filled with the proposals, its capacity is kept for reuse
+ */
+void generate_proposals(const float *feat_ptr, int num_array, int num_classes,
+			float prob_threshold, const uint8_t *allowed_classes,
+			const DetectionQuery &query, std::vector<Object> &objects);
+
+} // namespace edgeyolo_cpp
+
+#endif
@@ -15,7 +15,8 @@ EdgeYOLOONNXRuntime::EdgeYOLOONNXRuntime(file_name_t path_to_model, int intra_op
 {
 }
 
-std::vector<Object> EdgeYOLOONNXRuntime::inference(const cv::Mat &frame)
+std::vector<Object> EdgeYOLOONNXRuntime::inference(const cv::Mat &frame,
+						   const DetectionQuery &query)
 {
 	ONNXRuntimeModel::inference(frame, 0);
 
@@ -26,8 +27,32 @@ std::vector<Object> EdgeYOLOONNXRuntime::inference(const cv::Mat &frame)
 				 (float)input_h_[0] / (float)frame.rows);
 	std::vector<Object> objects;
 	decode_outputs(net_pred, this->num_array_, objects, this->bbox_conf_thresh_, scale,
-		       frame.cols, frame.rows);
+		       frame.cols, frame.rows, query);
 	return objects;
 }
 
+std::vector<std::vector<Object>>
+EdgeYOLOONNXRuntime::inferenceBatch(const std::vector<cv::Mat> &frames,
+				    const DetectionQuery &query)
+{
+	if (!this->dynamic_batch_ || this->input_tensor_.size() != 1 || frames.size() < 2) {
+		return ONNXRuntimeModel::inferenceBatch(frames, query);
+	}
+
+	std::vector<Ort::Value> outputs = this->runBatch(frames);
+	const float *net_pred = outputs[0].GetTensorData<float>();
+	const size_t sample_count = (size_t)this->num_array_ * (size_t)(5 + this->num_classes_);
+
+	// post process every sample of the batch
+	std::vector<std::vector<Object>> results(frames.size());
+	for (size_t i = 0; i < frames.size(); i++) {
+		const cv::Mat &frame = frames[i];
+		float scale = std::fminf((float)input_w_[0] / (float)frame.cols,
+					 (float)input_h_[0] / (float)frame.rows);
+		decode_outputs(net_pred + i * sample_count, this->num_array_, results[i],
+			       this->bbox_conf_thresh_, scale, frame.cols, frame.rows, query);
+	}
+	return results;
+}
+
 } // namespace edgeyolo_cpp
@@ -20,7 +20,11 @@ public:
 			    int num_classes = 80, int inter_op_num_threads = 1,
 			    const std::string &use_gpu_ = "", int device_id = 0,
 			    bool use_parallel = false, float nms_th = 0.45f, float conf_th = 0.3f);
-	std::vector<Object> inference(const cv::Mat &frame) override;
+	std::vector<Object> inference(const cv::Mat &frame,
+				      const DetectionQuery &query = DetectionQuery()) override;
+	std::vector<std::vector<Object>>
+	inferenceBatch(const std::vector<cv::Mat> &frames,
+		       const DetectionQuery &query = DetectionQuery()) override;
 };
 
 } // namespace edgeyolo_cpp
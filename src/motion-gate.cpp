@@ -0,0 +1,70 @@
+#include "motion-gate.h"
+
+#include <cstdlib>
+#include <utility>
+
+// size of the block grid the frames are reduced to
+static const int GRID_COLS = 64;
+static const int GRID_ROWS = 36;
+// sampled pixels per block along each axis
+static const int BLOCK_SAMPLES = 4;
+// block luma changes up to this level are treated as noise
+static const int NOISE_LEVEL = 8;
+
+static void block_luma(const cv::Mat &imageBGRA, std::vector<uint8_t> &blocks)
+{
+	blocks.resize((size_t)(GRID_COLS * GRID_ROWS));
+	const int channels = imageBGRA.channels();
+
+	for (int by = 0; by < GRID_ROWS; by++) {
+		const int y0 = by * imageBGRA.rows / GRID_ROWS;
+		const int y1 = (by + 1) * imageBGRA.rows / GRID_ROWS;
+		for (int bx = 0; bx < GRID_COLS; bx++) {
+			const int x0 = bx * imageBGRA.cols / GRID_COLS;
+			const int x1 = (bx + 1) * imageBGRA.cols / GRID_COLS;
+
+			int sum = 0;
+			for (int sy = 0; sy < BLOCK_SAMPLES; sy++) {
+				const int y = y0 + (2 * sy + 1) * (y1 - y0) / (2 * BLOCK_SAMPLES);
+				const uint8_t *row = imageBGRA.ptr<uint8_t>(y);
+				for (int sx = 0; sx < BLOCK_SAMPLES; sx++) {
+					const int x =
+						x0 + (2 * sx + 1) * (x1 - x0) / (2 * BLOCK_SAMPLES);
+					const uint8_t *px = row + x * channels;
+					// BT.601 luma in 8-bit fixed point
+					sum += (29 * px[0] + 150 * px[1] + 77 * px[2]) >> 8;
+				}
+			}
+			blocks[(size_t)(by * GRID_COLS + bx)] =
+				(uint8_t)(sum / (BLOCK_SAMPLES * BLOCK_SAMPLES));
+		}
+	}
+}
+
+bool motion_gate_should_run(motion_gate &gate, const cv::Mat &imageBGRA, float threshold,
+			    uint32_t maxSkip)
+{
+	block_luma(imageBGRA, gate.current);
+
+	bool run = true;
+	if (imageBGRA.size() == gate.referenceSize && gate.skippedFrames < maxSkip) {
+		size_t changed = 0;
+		for (size_t i = 0; i < gate.current.size(); i++) {
+			if (std::abs((int)gate.current[i] - (int)gate.reference[i]) > NOISE_LEVEL) {
+				changed++;
+			}
+		}
+		const float changedPercent =
+			100.0f * (float)changed / (float)gate.current.size();
+		run = changedPercent >= threshold;
+	}
+
+	if (run) {
+		std::swap(gate.reference, gate.current);
+		gate.referenceSize = imageBGRA.size();
+		gate.skippedFrames = 0;
+	} else {
+		gate.skippedFrames++;
+	}
+	return run;
+}
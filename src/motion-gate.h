@@ -0,0 +1,34 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/**
+  * @brief Cheap change detector used to skip inference on unchanged frames
+  *
+  * Frames are reduced to a coarse grid of block luma averages, sampled sparsely inside each
+  * block. A frame is compared against the reference, which is the last frame the model ran
+  * on, so slow changes add up until they trigger inference.
+*/
+struct motion_gate {
+	std::vector<uint8_t> reference;
+	std::vector<uint8_t> current;
+	cv::Size referenceSize;
+	uint32_t skippedFrames = 0;
+};
+
+/**
+  * @brief Decide whether the model has to run on the frame
+  *
+  * @param imageBGRA  The frame (or crop) that would go to the model
+  * @param threshold  Percentage of blocks that must change to run the model
+  * @param maxSkip  Maximal number of consecutive skipped frames, bounds staleness
+  * @return true if the model should run, the frame then becomes the new reference
+*/
+bool motion_gate_should_run(motion_gate &gate, const cv::Mat &imageBGRA, float threshold,
+			    uint32_t maxSkip);
+
+#endif // MOTION_GATE_H
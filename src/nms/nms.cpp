@@ -0,0 +1,346 @@
+#include "nms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NMS_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define NMS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// candidate count (after the top K selection) from which the hard NMS buckets the boxes in a
+// spatial grid, the grid costs more than it saves below this on clustered proposals
+static const size_t GRID_MIN_BOXES = 2048;
+// maximal number of grid cells along each axis
+static const int GRID_MAX_CELLS = 32;
+
+namespace {
+
+// candidates in descending score order, as structure of arrays
+struct BoxArrays {
+	std::vector<float> x1;
+	std::vector<float> y1;
+	std::vector<float> x2;
+	std::vector<float> y2;
+	std::vector<float> area;
+	std::vector<int32_t> label;
+	// index of the box in the input objects
+	std::vector<int> index;
+
+	void resize(size_t n)
+	{
+		x1.resize(n);
+		y1.resize(n);
+		x2.resize(n);
+		y2.resize(n);
+		area.resize(n);
+		label.resize(n);
+		index.resize(n);
+	}
+};
+
+struct NmsBuffers {
+	std::vector<int> order;
+	BoxArrays boxes;
+	std::vector<uint8_t> suppressed;
+	std::vector<float> scores;
+	std::vector<std::vector<int>> cells;
+	std::vector<int> visited;
+};
+
+} // namespace
+
+// reused between calls, every detection worker has its own
+static thread_local NmsBuffers buffers;
+
+static inline float box_iou(const BoxArrays &b, size_t i, size_t j)
+{
+	const float w = std::max(std::min(b.x2[i], b.x2[j]) - std::max(b.x1[i], b.x1[j]), 0.0f);
+	const float h = std::max(std::min(b.y2[i], b.y2[j]) - std::max(b.y1[i], b.y1[j]), 0.0f);
+	const float inter = w * h;
+	const float uni = b.area[i] + b.area[j] - inter;
+	return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+// IoU above the threshold, written without the division like the SIMD version
+static inline bool box_overlaps(const BoxArrays &b, size_t i, size_t j, float threshold,
+				bool classAware)
+{
+	if (classAware && b.label[i] != b.label[j]) {
+		return false;
+	}
+	const float w = std::max(std::min(b.x2[i], b.x2[j]) - std::max(b.x1[i], b.x1[j]), 0.0f);
+	const float h = std::max(std::min(b.y2[i], b.y2[j]) - std::max(b.y1[i], b.y1[j]), 0.0f);
+	const float inter = w * h;
+	return inter > threshold * (b.area[i] + b.area[j] - inter);
+}
+
+// mark the boxes in [begin, end) overlapping box i
+static void suppress_range(const BoxArrays &b, size_t i, size_t begin, size_t end,
+			   float threshold, bool classAware, uint8_t *suppressed)
+{
+	size_t j = begin;
+#if defined(NMS_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 thr = _mm_set1_ps(threshold);
+	const __m128 ix1 = _mm_set1_ps(b.x1[i]);
+	const __m128 iy1 = _mm_set1_ps(b.y1[i]);
+	const __m128 ix2 = _mm_set1_ps(b.x2[i]);
+	const __m128 iy2 = _mm_set1_ps(b.y2[i]);
+	const __m128 iarea = _mm_set1_ps(b.area[i]);
+	const __m128i ilabel = _mm_set1_epi32(b.label[i]);
+	for (; j + 4 <= end; j += 4) {
+		const __m128 w = _mm_max_ps(_mm_sub_ps(_mm_min_ps(ix2, _mm_loadu_ps(&b.x2[j])),
+						       _mm_max_ps(ix1, _mm_loadu_ps(&b.x1[j]))),
+					    zero);
+		const __m128 h = _mm_max_ps(_mm_sub_ps(_mm_min_ps(iy2, _mm_loadu_ps(&b.y2[j])),
+						       _mm_max_ps(iy1, _mm_loadu_ps(&b.y1[j]))),
+					    zero);
+		const __m128 inter = _mm_mul_ps(w, h);
+		const __m128 uni = _mm_sub_ps(_mm_add_ps(iarea, _mm_loadu_ps(&b.area[j])), inter);
+		__m128 over = _mm_cmpgt_ps(inter, _mm_mul_ps(thr, uni));
+		if (classAware) {
+			const __m128i label = _mm_loadu_si128((const __m128i *)&b.label[j]);
+			over = _mm_and_ps(over, _mm_castsi128_ps(_mm_cmpeq_epi32(ilabel, label)));
+		}
+		const int mask = _mm_movemask_ps(over);
+		if (mask != 0) {
+			for (int k = 0; k < 4; k++) {
+				if (mask & (1 << k)) {
+					suppressed[j + (size_t)k] = 1;
+				}
+			}
+		}
+	}
+#elif defined(NMS_NEON)
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t thr = vdupq_n_f32(threshold);
+	const float32x4_t ix1 = vdupq_n_f32(b.x1[i]);
+	const float32x4_t iy1 = vdupq_n_f32(b.y1[i]);
+	const float32x4_t ix2 = vdupq_n_f32(b.x2[i]);
+	const float32x4_t iy2 = vdupq_n_f32(b.y2[i]);
+	const float32x4_t iarea = vdupq_n_f32(b.area[i]);
+	const int32x4_t ilabel = vdupq_n_s32(b.label[i]);
+	for (; j + 4 <= end; j += 4) {
+		const float32x4_t w = vmaxq_f32(vsubq_f32(vminq_f32(ix2, vld1q_f32(&b.x2[j])),
+							  vmaxq_f32(ix1, vld1q_f32(&b.x1[j]))),
+						zero);
+		const float32x4_t h = vmaxq_f32(vsubq_f32(vminq_f32(iy2, vld1q_f32(&b.y2[j])),
+							  vmaxq_f32(iy1, vld1q_f32(&b.y1[j]))),
+						zero);
+		const float32x4_t inter = vmulq_f32(w, h);
+		const float32x4_t uni = vsubq_f32(vaddq_f32(iarea, vld1q_f32(&b.area[j])), inter);
+		uint32x4_t over = vcgtq_f32(inter, vmulq_f32(thr, uni));
+		if (classAware) {
+			over = vandq_u32(over, vceqq_s32(ilabel, vld1q_s32(&b.label[j])));
+		}
+		if (vmaxvq_u32(over) != 0) {
+			uint32_t lanes[4];
+			vst1q_u32(lanes, over);
+			for (size_t k = 0; k < 4; k++) {
+				if (lanes[k] != 0) {
+					suppressed[j + k] = 1;
+				}
+			}
+		}
+	}
+#endif
+	for (; j < end; j++) {
+		if (box_overlaps(b, i, j, threshold, classAware)) {
+			suppressed[j] = 1;
+		}
+	}
+}
+
+static void nms_dense(const BoxArrays &b, size_t n, std::vector<int> &picked,
+		      const NmsOptions &options)
+{
+	buffers.suppressed.assign(n, 0);
+	uint8_t *suppressed = buffers.suppressed.data();
+
+	for (size_t i = 0; i < n; i++) {
+		if (suppressed[i]) {
+			continue;
+		}
+		picked.push_back(b.index[i]);
+		if (options.maxDetections > 0 && picked.size() >= options.maxDetections) {
+			break;
+		}
+		suppress_range(b, i, i + 1, n, options.iouThreshold, options.classAware,
+			       suppressed);
+	}
+}
+
+// Same result as nms_dense, but a kept box is only compared with the boxes sharing a grid
+// cell with it. Two overlapping boxes always share at least one cell.
+static void nms_grid(const BoxArrays &b, size_t n, std::vector<int> &picked,
+		     const NmsOptions &options)
+{
+	float minX = b.x1[0], minY = b.y1[0], maxX = b.x2[0], maxY = b.y2[0];
+	float sumW = 0.0f, sumH = 0.0f;
+	for (size_t i = 0; i < n; i++) {
+		minX = std::min(minX, b.x1[i]);
+		minY = std::min(minY, b.y1[i]);
+		maxX = std::max(maxX, b.x2[i]);
+		maxY = std::max(maxY, b.y2[i]);
+		sumW += b.x2[i] - b.x1[i];
+		sumH += b.y2[i] - b.y1[i];
+	}
+	// cells about the size of an average box
+	const float cellW = std::max({sumW / (float)n, (maxX - minX) / (float)GRID_MAX_CELLS,
+				      1.0f});
+	const float cellH = std::max({sumH / (float)n, (maxY - minY) / (float)GRID_MAX_CELLS,
+				      1.0f});
+	const int cols = std::min((int)((maxX - minX) / cellW) + 1, GRID_MAX_CELLS);
+	const int rows = std::min((int)((maxY - minY) / cellH) + 1, GRID_MAX_CELLS);
+	auto cellX = [&](float x) {
+		return std::min(std::max((int)((x - minX) / cellW), 0), cols - 1);
+	};
+	auto cellY = [&](float y) {
+		return std::min(std::max((int)((y - minY) / cellH), 0), rows - 1);
+	};
+
+	std::vector<std::vector<int>> &cells = buffers.cells;
+	if (cells.size() < (size_t)(cols * rows)) {
+		cells.resize((size_t)(cols * rows));
+	}
+	for (int c = 0; c < cols * rows; c++) {
+		cells[(size_t)c].clear();
+	}
+	// boxes are added in score order, so every cell lists them in score order
+	for (size_t i = 0; i < n; i++) {
+		for (int cy = cellY(b.y1[i]); cy <= cellY(b.y2[i]); cy++) {
+			for (int cx = cellX(b.x1[i]); cx <= cellX(b.x2[i]); cx++) {
+				cells[(size_t)(cy * cols + cx)].push_back((int)i);
+			}
+		}
+	}
+
+	buffers.suppressed.assign(n, 0);
+	buffers.visited.assign(n, -1);
+	uint8_t *suppressed = buffers.suppressed.data();
+	int *visited = buffers.visited.data();
+
+	for (size_t i = 0; i < n; i++) {
+		if (suppressed[i]) {
+			continue;
+		}
+		picked.push_back(b.index[i]);
+		if (options.maxDetections > 0 && picked.size() >= options.maxDetections) {
+			break;
+		}
+		for (int cy = cellY(b.y1[i]); cy <= cellY(b.y2[i]); cy++) {
+			for (int cx = cellX(b.x1[i]); cx <= cellX(b.x2[i]); cx++) {
+				const std::vector<int> &cell = cells[(size_t)(cy * cols + cx)];
+				// skip the boxes with a higher score, they were decided already
+				auto it = std::upper_bound(cell.begin(), cell.end(), (int)i);
+				for (; it != cell.end(); ++it) {
+					const size_t j = (size_t)*it;
+					if (suppressed[j] || visited[j] == (int)i) {
+						continue;
+					}
+					visited[j] = (int)i;
+					if (box_overlaps(b, i, j, options.iouThreshold,
+							 options.classAware)) {
+						suppressed[j] = 1;
+					}
+				}
+			}
+		}
+	}
+}
+
+// Gaussian Soft-NMS (Bodla et al. 2017)
+static void nms_soft(std::vector<Object> &objects, const BoxArrays &b, size_t n,
+		     std::vector<int> &picked, const NmsOptions &options)
+{
+	std::vector<float> &scores = buffers.scores;
+	scores.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		scores[i] = objects[(size_t)b.index[i]].prob;
+	}
+	buffers.suppressed.assign(n, 0);
+	uint8_t *removed = buffers.suppressed.data();
+
+	while (true) {
+		// the best remaining box
+		size_t best = n;
+		for (size_t i = 0; i < n; i++) {
+			if (!removed[i] && (best == n || scores[i] > scores[best])) {
+				best = i;
+			}
+		}
+		if (best == n) {
+			break;
+		}
+		removed[best] = 1;
+		objects[(size_t)b.index[best]].prob = scores[best];
+		picked.push_back(b.index[best]);
+		if (options.maxDetections > 0 && picked.size() >= options.maxDetections) {
+			break;
+		}
+
+		for (size_t j = 0; j < n; j++) {
+			if (removed[j] || (options.classAware && b.label[j] != b.label[best])) {
+				continue;
+			}
+			const float iou = box_iou(b, best, j);
+			scores[j] *= std::exp(-(iou * iou) / options.softSigma);
+			if (scores[j] < options.scoreThreshold) {
+				removed[j] = 1;
+			}
+		}
+	}
+}
+
+void nms(std::vector<Object> &objects, std::vector<int> &picked, const NmsOptions &options)
+{
+	picked.clear();
+	if (objects.empty()) {
+		return;
+	}
+
+	// order by descending score, only the top K candidates are sorted completely
+	std::vector<int> &order = buffers.order;
+	order.resize(objects.size());
+	std::iota(order.begin(), order.end(), 0);
+	auto higher = [&objects](int a, int b) {
+		const float pa = objects[(size_t)a].prob;
+		const float pb = objects[(size_t)b].prob;
+		return pa > pb || (pa == pb && a < b);
+	};
+	size_t n = order.size();
+	if (options.topK > 0 && options.topK < n) {
+		n = options.topK;
+		std::partial_sort(order.begin(), order.begin() + (std::ptrdiff_t)n, order.end(),
+				  higher);
+	} else {
+		std::sort(order.begin(), order.end(), higher);
+	}
+
+	BoxArrays &b = buffers.boxes;
+	b.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		const Object &obj = objects[(size_t)order[i]];
+		b.x1[i] = obj.rect.x;
+		b.y1[i] = obj.rect.y;
+		b.x2[i] = obj.rect.x + obj.rect.width;
+		b.y2[i] = obj.rect.y + obj.rect.height;
+		b.area[i] = obj.rect.area();
+		b.label[i] = obj.label;
+		b.index[i] = order[i];
+	}
+
+	if (options.soft) {
+		nms_soft(objects, b, n, picked, options);
+	} else if (n >= GRID_MIN_BOXES) {
+		nms_grid(b, n, picked, options);
+	} else {
+		nms_dense(b, n, picked, options);
+	}
+}
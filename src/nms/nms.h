@@ -0,0 +1,40 @@
+#ifndef NMS_H
+#define NMS_H
+
+#include <cstddef>
+#include <vector>
+
+#include "ort-model/types.hpp"
+
+/**
+ * @brief Options of the non-maximum suppression
+ */
+struct NmsOptions {
+	// boxes overlapping a kept box by more than this IoU are suppressed
+	float iouThreshold = 0.45f;
+	// only suppress boxes of the same label
+	bool classAware = false;
+	// Gaussian Soft-NMS: decay the score of overlapping boxes instead of removing them
+	bool soft = false;
+	float softSigma = 0.5f;
+	// Soft-NMS drops boxes whose decayed score falls below this
+	float scoreThreshold = 0.0f;
+	// candidates kept (by score) before the suppression, 0 keeps all
+	size_t topK = 0;
+	// stop once this many boxes are kept, 0 for no limit
+	size_t maxDetections = 0;
+};
+
+/**
+ * @brief Non-maximum suppression of detected objects
+ *
+ * The objects do not need to be sorted. Boxes are stored as structure of arrays in score
+ * order, overlaps are computed four at a time with SSE2 or NEON. Large candidate sets are
+ * bucketed in a spatial grid so that a kept box is only compared with its neighbours.
+ *
+ * @param objects  Candidates, Soft-NMS updates the scores of the kept objects
+ * @param picked  Indices of the kept objects in descending score order
+ */
+void nms(std::vector<Object> &objects, std::vector<int> &picked, const NmsOptions &options);
+
+#endif // NMS_H
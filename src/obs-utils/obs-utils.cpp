@@ -3,9 +3,34 @@
 
 #include <obs-module.h>
 
+#include <algorithm>
+#include <cmath>
+
+/**
+  * @brief Reset and begin a texrender
+  *
+  * The texrender keeps its texture while the size stays the same, a new size allocates a new
+  * one, which is counted in the GPU allocation stats.
+*/
+bool begin_texrender(filter_data *tf, gs_texrender_t *texrender, uint32_t width,
+		     uint32_t height)
+{
+	gs_texture_t *current = gs_texrender_get_texture(texrender);
+	if (current == nullptr || gs_texture_get_width(current) != width ||
+	    gs_texture_get_height(current) != height) {
+		tf->stats.gpuAllocations++;
+	}
+	gs_texrender_reset(texrender);
+	return gs_texrender_begin(texrender, width, height);
+}
+
 /**
   * @brief Get RGBA from the stage surface
   *
+  * Renders the filter target into the texrender and stages it into the ring of stage
+  * surfaces. The frame handed to the detection worker is the one staged readbackLatency
+  * renders ago, whose copy has finished on the GPU by now, so mapping it does not stall.
+  *
   * @param tf  The filter data
   * @param width  The width of the stage surface (output)
   * @param height  The height of the stage surface (output)
@@ -28,8 +53,7 @@ bool getRGBAFromStageSurface(filter_data *tf, uint32_t &width, uint32_t &height)
 	if (width == 0 || height == 0) {
 		return false;
 	}
-	gs_texrender_reset(tf->texrender);
-	if (!gs_texrender_begin(tf->texrender, width, height)) {
+	if (!begin_texrender(tf, tf->texrender, width, height)) {
 		return false;
 	}
 	struct vec4 background;
@@ -43,102 +67,386 @@ bool getRGBAFromStageSurface(filter_data *tf, uint32_t &width, uint32_t &height)
 	gs_blend_state_pop();
 	gs_texrender_end(tf->texrender);
 
-	if (tf->stagesurface) {
-		uint32_t stagesurf_width = gs_stagesurface_get_width(tf->stagesurface);
-		uint32_t stagesurf_height = gs_stagesurface_get_height(tf->stagesurface);
-		if (stagesurf_width != width || stagesurf_height != height) {
-			gs_stagesurface_destroy(tf->stagesurface);
-			tf->stagesurface = nullptr;
+	// only the inference region is read back, scaled down on the GPU to the model input
+	// size. Tiled inference slices the full resolution, it reads back the region unscaled.
+	const cv::Rect region = getCropRect(tf, width, height);
+	// the input size of the model that detected the latest results, the loader may be
+	// swapping in another one
+	const std::shared_ptr<const model_info> &model = tf->output.readBuffer().model;
+	float scale = 1.0f;
+	if (!tf->tiledInference && model && !model->inputSize.empty()) {
+		scale = std::min({1.0f, (float)model->inputSize.width / (float)region.width,
+				  (float)model->inputSize.height / (float)region.height});
+	}
+	const uint32_t readWidth = (uint32_t)std::max((int)((float)region.width * scale), 1);
+	const uint32_t readHeight = (uint32_t)std::max((int)((float)region.height * scale), 1);
+
+	gs_texture_t *readTexture = gs_texrender_get_texture(tf->texrender);
+	if (readWidth != width || readHeight != height) {
+		if (!begin_texrender(tf, tf->readbackTexrender, readWidth, readHeight)) {
+			return false;
+		}
+		// the projection maps the region onto the smaller target
+		gs_ortho((float)region.x, (float)(region.x + region.width), (float)region.y,
+			 (float)(region.y + region.height), -100.0f, 100.0f);
+		gs_blend_state_push();
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+		gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+		gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), readTexture);
+		while (gs_effect_loop(effect, "Draw")) {
+			gs_draw_sprite(readTexture, 0, width, height);
 		}
+		gs_blend_state_pop();
+		gs_texrender_end(tf->readbackTexrender);
+		readTexture = gs_texrender_get_texture(tf->readbackTexrender);
+	}
+
+	// stage the current frame, then map the one staged readbackLatency renders ago. Each
+	// slot keeps the region and size of its frame, so a resize does not flush the ring.
+	const uint32_t latency =
+		(uint32_t)std::min(std::max(tf->readbackLatency, 0), STAGE_SURFACE_COUNT - 1);
+	stage_slot &stageSlot = tf->stageSlots[tf->stageIndex % STAGE_SURFACE_COUNT];
+	stage_slot &mapSlot =
+		tf->stageSlots[(tf->stageIndex + STAGE_SURFACE_COUNT - latency) %
+			       STAGE_SURFACE_COUNT];
+	tf->stageIndex++;
+	if (stageSlot.surface && (gs_stagesurface_get_width(stageSlot.surface) != readWidth ||
+				  gs_stagesurface_get_height(stageSlot.surface) != readHeight)) {
+		gs_stagesurface_destroy(stageSlot.surface);
+		stageSlot.surface = nullptr;
 	}
-	if (!tf->stagesurface) {
-		tf->stagesurface = gs_stagesurface_create(width, height, GS_BGRA);
+	if (!stageSlot.surface) {
+		stageSlot.surface = gs_stagesurface_create(readWidth, readHeight, GS_BGRA);
+		tf->stats.gpuAllocations++;
+		if (!stageSlot.surface) {
+			return false;
+		}
 	}
-	gs_stage_texture(tf->stagesurface, gs_texrender_get_texture(tf->texrender));
+	gs_stage_texture(stageSlot.surface, readTexture);
+	stageSlot.pending = true;
+	stageSlot.region = region;
+	stageSlot.sourceSize = cv::Size((int)width, (int)height);
+	if (!mapSlot.pending) {
+		// the ring is still filling up, the texrender holds the frame for rendering
+		return true;
+	}
+	mapSlot.pending = false;
+
 	uint8_t *video_data;
 	uint32_t linesize;
-	if (!gs_stagesurface_map(tf->stagesurface, &video_data, &linesize)) {
+	if (!gs_stagesurface_map(mapSlot.surface, &video_data, &linesize)) {
 		return false;
 	}
 	{
-		std::lock_guard<std::mutex> lock(tf->inputBGRALock);
-		tf->inputBGRA = cv::Mat(height, width, CV_8UC4, video_data, linesize);
+		// copy the frame into the input buffer while the stage surface is still mapped,
+		// publishing it replaces any frame that the detection worker did not pick up yet
+		const cv::Mat mapped((int)gs_stagesurface_get_height(mapSlot.surface),
+				     (int)gs_stagesurface_get_width(mapSlot.surface), CV_8UC4,
+				     video_data, linesize);
+		captured_frame &frame = tf->input.writeBuffer();
+		if (frame.imageBGRA.size() != mapped.size() || frame.imageBGRA.type() != CV_8UC4) {
+			tf->framePool.release(frame.imageBGRA);
+			frame.imageBGRA = tf->framePool.acquire(mapped.size(), CV_8UC4);
+		}
+		mapped.copyTo(frame.imageBGRA);
+		frame.region = mapSlot.region;
+		frame.sourceSize = mapSlot.sourceSize;
+		frame.timestamp = std::chrono::steady_clock::now();
+		if (!tf->input.publish()) {
+			tf->stats.framesDropped++;
+		}
+		tf->stats.framesSubmitted++;
+	}
+	gs_stagesurface_unmap(mapSlot.surface);
+	{
+		// the worker checks for a frame under this lock before it sleeps, taking it here
+		// makes sure the notification is not lost in between
+		std::lock_guard<std::mutex> lock(tf->inputWakeLock);
 	}
-	gs_stagesurface_unmap(tf->stagesurface);
+	tf->inputCondition.notify_one();
 	return true;
 }
 
+cv::Rect getCropRect(filter_data *tf, uint32_t width, uint32_t height)
+{
+	const cv::Rect frame(0, 0, (int)width, (int)height);
+	if (!tf->crop_enabled) {
+		return frame;
+	}
+	const cv::Rect crop = cv::Rect(tf->crop_left, tf->crop_top,
+				       (int)width - tf->crop_left - tf->crop_right,
+				       (int)height - tf->crop_top - tf->crop_bottom) &
+			      frame;
+	// a crop larger than the frame falls back to the whole frame
+	return crop.empty() ? frame : crop;
+}
+
+// the size of the mask_boxes array of masking.effect
+static const size_t MASK_BOXES_PER_DRAW = 32;
+
+/**
+  * @brief Draw a rectangle of the render target with an effect
+  *
+  * The effect's vertex shader maps the positions to texture coordinates with the region
+  * uniform, so only the pixels of the rectangle are shaded. Drawing geometry instead of
+  * setting a scissor rectangle behaves the same on every graphics backend.
+*/
+static void draw_region(gs_effect_t *effect, const char *technique, const cv::Rect &rect,
+			uint32_t width, uint32_t height)
+{
+	struct vec4 region;
+	vec4_set(&region, (float)rect.x, (float)rect.y, 1.0f / (float)width,
+		 1.0f / (float)height);
+	gs_effect_set_vec4(gs_effect_get_param_by_name(effect, "region"), &region);
+	// the projection puts the origin of the sprite at the corner of the rectangle
+	gs_ortho(-(float)rect.x, (float)width - (float)rect.x, -(float)rect.y,
+		 (float)height - (float)rect.y, -100.0f, 100.0f);
+	while (gs_effect_loop(effect, technique)) {
+		gs_draw_sprite(nullptr, 0, (uint32_t)rect.width, (uint32_t)rect.height);
+	}
+}
+
+cv::Rect get_mask_region(filter_data *tf, uint32_t width, uint32_t height,
+			 const std::vector<Object> &objects)
+{
+	// the dilation and the feathering grow the boxes, one more pixel for the edge ramp
+	const float grow = (float)tf->maskingDilateIterations +
+			   (tf->maskingEdge == "feathered" ? (float)tf->maskingEdgeSize : 0.0f) +
+			   1.0f;
+	cv::Rect_<float> bounds;
+	for (const Object &obj : objects) {
+		const cv::Rect_<float> box(obj.rect.x - grow, obj.rect.y - grow,
+					   obj.rect.width + 2.0f * grow,
+					   obj.rect.height + 2.0f * grow);
+		bounds = bounds.area() > 0.0f ? (bounds | box) : box;
+	}
+	const cv::Rect region((int)std::floor(bounds.x), (int)std::floor(bounds.y),
+			      (int)std::ceil(bounds.x + bounds.width) - (int)std::floor(bounds.x),
+			      (int)std::ceil(bounds.y + bounds.height) -
+				      (int)std::floor(bounds.y));
+	return region & cv::Rect(0, 0, (int)width, (int)height);
+}
+
+/**
+  * @brief Rasterize the object boxes into the mask texrender
+  *
+  * Only the box list goes to the GPU: the masking effect evaluates the coverage of every pixel
+  * by the boxes, in draws of up to MASK_BOXES_PER_DRAW boxes blended together. The dilation
+  * grows every box by one pixel per iteration, which is what dilating a rectangle with a 3x3
+  * kernel does. Rounded corners and feathered edges follow the masking edge setting.
+  * Only the mask region is drawn, the rest of the mask is cleared.
+  *
+  * @return the mask texture, owned by the texrender and valid until its next render
+*/
+gs_texture_t *render_box_mask(struct filter_data *tf, uint32_t width, uint32_t height,
+			      const std::vector<Object> &objects, const cv::Rect &region)
+{
+	if (!begin_texrender(tf, tf->maskTexrender, width, height)) {
+		obs_log(LOG_INFO, "Could not open mask texrender!");
+		return nullptr;
+	}
+	struct vec4 background;
+	vec4_zero(&background);
+	gs_clear(GS_CLEAR_COLOR, &background, 0.0f, 0);
+
+	if (!objects.empty() && !region.empty()) {
+		gs_eparam_t *boxesParam =
+			gs_effect_get_param_by_name(tf->maskingEffect, "mask_boxes");
+		gs_eparam_t *countParam =
+			gs_effect_get_param_by_name(tf->maskingEffect, "mask_box_count");
+		gs_eparam_t *sizeParam =
+			gs_effect_get_param_by_name(tf->maskingEffect, "mask_size");
+		gs_eparam_t *radiusParam =
+			gs_effect_get_param_by_name(tf->maskingEffect, "corner_radius");
+		gs_eparam_t *featherParam =
+			gs_effect_get_param_by_name(tf->maskingEffect, "feather");
+
+		struct vec2 maskSize;
+		vec2_set(&maskSize, (float)width, (float)height);
+		gs_effect_set_vec2(sizeParam, &maskSize);
+		gs_effect_set_float(radiusParam, tf->maskingEdge == "rounded"
+							 ? (float)tf->maskingEdgeSize
+							 : 0.0f);
+		gs_effect_set_float(featherParam, tf->maskingEdge == "feathered"
+							  ? (float)tf->maskingEdgeSize
+							  : 0.0f);
+
+		// later draws add their coverage to the earlier ones: src + dst * (1 - src)
+		gs_blend_state_push();
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCCOLOR);
+
+		const float dilation = (float)tf->maskingDilateIterations;
+		struct vec4 boxes[MASK_BOXES_PER_DRAW];
+		for (size_t first = 0; first < objects.size(); first += MASK_BOXES_PER_DRAW) {
+			const size_t count = std::min(MASK_BOXES_PER_DRAW, objects.size() - first);
+			for (size_t i = 0; i < count; i++) {
+				const cv::Rect_<float> &rect = objects[first + i].rect;
+				vec4_set(&boxes[i], rect.x + rect.width * 0.5f,
+					 rect.y + rect.height * 0.5f, rect.width * 0.5f + dilation,
+					 rect.height * 0.5f + dilation);
+			}
+			gs_effect_set_val(boxesParam, boxes, sizeof(boxes));
+			gs_effect_set_int(countParam, (int)count);
+			draw_region(tf->maskingEffect, "DrawBoxMask", region, width, height);
+		}
+		gs_blend_state_pop();
+	}
+
+	gs_texrender_end(tf->maskTexrender);
+	return gs_texrender_get_texture(tf->maskTexrender);
+}
+
+// the rectangle of a pyramid level covering the region of the full size frame, with a texel
+// to spare for the bilinear samples
+static cv::Rect level_region(const cv::Rect &region, int level, uint32_t width, uint32_t height)
+{
+	const int scale = 1 << level;
+	const int left = region.x / scale - 1;
+	const int top = region.y / scale - 1;
+	const int right = (region.x + region.width + scale - 1) / scale + 1;
+	const int bottom = (region.y + region.height + scale - 1) / scale + 1;
+	return cv::Rect(left, top, right - left, bottom - top) &
+	       cv::Rect(0, 0, (int)width, (int)height);
+}
+
+// render the region of one level of the blur pyramid from the source texture
+static bool blur_pass(filter_data *tf, gs_texrender_t *target, uint32_t width, uint32_t height,
+		      const cv::Rect &region, gs_texture_t *source, float offset,
+		      const char *technique)
+{
+	if (!begin_texrender(tf, target, width, height)) {
+		obs_log(LOG_INFO, "Could not open background blur texrender!");
+		return false;
+	}
+	gs_effect_set_texture(gs_effect_get_param_by_name(tf->kawaseBlurEffect, "image"), source);
+	struct vec2 halfTexel;
+	vec2_set(&halfTexel, offset * 0.5f / (float)gs_texture_get_width(source),
+		 offset * 0.5f / (float)gs_texture_get_height(source));
+	gs_effect_set_vec2(gs_effect_get_param_by_name(tf->kawaseBlurEffect, "half_texel"),
+			   &halfTexel);
+
+	// outside the region the level stays clear, which carries no mask weight
+	struct vec4 background;
+	vec4_zero(&background);
+	gs_clear(GS_CLEAR_COLOR, &background, 0.0f, 0);
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	draw_region(tf->kawaseBlurEffect, technique, region, width, height);
+	gs_blend_state_pop();
+	gs_texrender_end(target);
+	return true;
+}
+
+/**
+  * @brief Blur the frame in the texrender with a dual Kawase pyramid
+  *
+  * The frame is downsampled level by level and upsampled back, every pass blurring a little.
+  * The blur radius picks the number of levels and scales the sample offsets in between, so
+  * the cost stays about the same for large radii: all the passes below full size together
+  * cost less than one more full size pass. Every pass only draws the region, grown by the
+  * reach of the blur on the way down, so the cost follows the masked area.
+  *
+  * @param alphaTexture  The mask, only masked pixels are blurred and take part in the blur
+  * @param region  The part of the frame to blur
+  * @return the blurred frame, owned by the blur texrender and valid until the next call. It
+  *         is only blurred inside the region, the masking effect blends it by the mask.
+*/
 gs_texture_t *blur_image(struct filter_data *tf, uint32_t width, uint32_t height,
-			 gs_texture_t *alphaTexture)
+			 gs_texture_t *alphaTexture, const cv::Rect &region)
 {
-	gs_texture_t *blurredTexture = gs_texture_create(width, height, GS_BGRA, 1, nullptr, 0);
-	gs_copy_texture(blurredTexture, gs_texrender_get_texture(tf->texrender));
+	gs_texture_t *frame = gs_texrender_get_texture(tf->texrender);
 	if (tf->kawaseBlurEffect == nullptr) {
 		obs_log(LOG_ERROR, "tf->kawaseBlurEffect is null");
-		return blurredTexture;
-	}
-	gs_eparam_t *image = gs_effect_get_param_by_name(tf->kawaseBlurEffect, "image");
-	gs_eparam_t *xOffset = gs_effect_get_param_by_name(tf->kawaseBlurEffect, "xOffset");
-	gs_eparam_t *yOffset = gs_effect_get_param_by_name(tf->kawaseBlurEffect, "yOffset");
-	gs_eparam_t *mask = gs_effect_get_param_by_name(tf->kawaseBlurEffect, "focalmask");
-
-	for (int i = 0; i < (int)tf->maskingBlurRadius; i++) {
-		gs_texrender_reset(tf->texrender);
-		if (!gs_texrender_begin(tf->texrender, width, height)) {
-			obs_log(LOG_INFO, "Could not open background blur texrender!");
-			return blurredTexture;
-		}
+		return frame;
+	}
+	if (tf->maskingBlurRadius <= 0 || region.empty()) {
+		return frame;
+	}
 
-		gs_effect_set_texture(image, blurredTexture);
-		if (alphaTexture != nullptr) {
-			gs_effect_set_texture(mask, alphaTexture);
-		}
-		gs_effect_set_float(xOffset, ((float)i + 0.5f) / (float)width);
-		gs_effect_set_float(yOffset, ((float)i + 0.5f) / (float)height);
-
-		struct vec4 background;
-		vec4_zero(&background);
-		gs_clear(GS_CLEAR_COLOR, &background, 0.0f, 0);
-		gs_ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height), -100.0f,
-			 100.0f);
-		gs_blend_state_push();
-		gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	// radius 1 blurs one level, 2-3 two levels, 4-7 three levels and so on
+	int levels = 1;
+	while (levels < BLUR_PYRAMID_LEVELS && (1 << levels) <= tf->maskingBlurRadius &&
+	       (width >> (levels + 1)) > 0 && (height >> (levels + 1)) > 0) {
+		levels++;
+	}
+	const float offset = (float)tf->maskingBlurRadius / (float)(1 << (levels - 1));
 
-		while (gs_effect_loop(tf->kawaseBlurEffect,
-				      (alphaTexture == nullptr) ? "Draw" : "DrawMaskAware")) {
-			gs_draw_sprite(blurredTexture, 0, width, height);
+	// the pixels of the region gather samples from about this far, farther away the weights
+	// are too small to matter
+	const int reach = (int)std::ceil(2.0f * offset * (float)(1 << levels));
+	const cv::Rect blurRegion =
+		cv::Rect(region.x - reach, region.y - reach, region.width + 2 * reach,
+			 region.height + 2 * reach) &
+		cv::Rect(0, 0, (int)width, (int)height);
+
+	gs_texture_t *source = frame;
+	for (int i = 0; i < levels; i++) {
+		const uint32_t levelWidth = std::max(width >> (i + 1), 1u);
+		const uint32_t levelHeight = std::max(height >> (i + 1), 1u);
+		const char *technique = (i == 0 && alphaTexture != nullptr) ? "DownsampleMaskAware"
+									  : "Downsample";
+		if (i == 0 && alphaTexture != nullptr) {
+			gs_effect_set_texture(
+				gs_effect_get_param_by_name(tf->kawaseBlurEffect, "focalmask"),
+				alphaTexture);
 		}
-		gs_blend_state_pop();
-		gs_texrender_end(tf->texrender);
-		gs_copy_texture(blurredTexture, gs_texrender_get_texture(tf->texrender));
+		if (!blur_pass(tf, tf->blurPyramid[i], levelWidth, levelHeight,
+			       level_region(blurRegion, i + 1, levelWidth, levelHeight), source,
+			       offset, technique)) {
+			return frame;
+		}
+		source = gs_texrender_get_texture(tf->blurPyramid[i]);
+	}
+	for (int i = levels - 2; i >= 0; i--) {
+		const uint32_t levelWidth = std::max(width >> (i + 1), 1u);
+		const uint32_t levelHeight = std::max(height >> (i + 1), 1u);
+		if (!blur_pass(tf, tf->blurPyramid[i], levelWidth, levelHeight,
+			       level_region(blurRegion, i + 1, levelWidth, levelHeight), source,
+			       offset, "Upsample")) {
+			return frame;
+		}
+		source = gs_texrender_get_texture(tf->blurPyramid[i]);
+	}
+
+	// the last upsample brings the blur of the region back to full size
+	if (alphaTexture != nullptr) {
+		gs_effect_set_texture(gs_effect_get_param_by_name(tf->kawaseBlurEffect, "original"),
+				      frame);
 	}
-	return blurredTexture;
+	if (!blur_pass(tf, tf->blurTexrender, width, height, region, source, offset,
+		       alphaTexture != nullptr ? "UpsampleMaskAware" : "Upsample")) {
+		return frame;
+	}
+	return gs_texrender_get_texture(tf->blurTexrender);
 }
 
+/**
+  * @brief Pixelate the region of the frame in the texrender
+  *
+  * @return the pixelated frame, owned by the pixelate texrender and valid until the next call.
+  *         It is only pixelated inside the region, the masking effect blends it by the mask.
+*/
 gs_texture_t *pixelate_image(struct filter_data *tf, uint32_t width, uint32_t height,
-			     gs_texture_t *alphaTexture, float pixelateRadius)
+			     const cv::Rect &region, float pixelateRadius)
 {
-	gs_texture_t *blurredTexture = gs_texture_create(width, height, GS_BGRA, 1, nullptr, 0);
-	gs_copy_texture(blurredTexture, gs_texrender_get_texture(tf->texrender));
+	gs_texture_t *frame = gs_texrender_get_texture(tf->texrender);
 	if (tf->pixelateEffect == nullptr) {
 		obs_log(LOG_ERROR, "tf->pixelateEffect is null");
-		return blurredTexture;
+		return frame;
+	}
+	if (region.empty()) {
+		return frame;
 	}
 	gs_eparam_t *image = gs_effect_get_param_by_name(tf->pixelateEffect, "image");
-	gs_eparam_t *mask = gs_effect_get_param_by_name(tf->pixelateEffect, "focalmask");
 	gs_eparam_t *pixel_size = gs_effect_get_param_by_name(tf->pixelateEffect, "pixel_size");
 	gs_eparam_t *tex_size = gs_effect_get_param_by_name(tf->pixelateEffect, "tex_size");
 
-	gs_texrender_reset(tf->texrender);
-	if (!gs_texrender_begin(tf->texrender, width, height)) {
+	if (!begin_texrender(tf, tf->pixelateTexrender, width, height)) {
 		obs_log(LOG_INFO, "Could not open background blur texrender!");
-		return blurredTexture;
+		return frame;
 	}
 
-	gs_effect_set_texture(image, blurredTexture);
-	if (alphaTexture != nullptr) {
-		gs_effect_set_texture(mask, alphaTexture);
-	}
+	gs_effect_set_texture(image, frame);
 	gs_effect_set_float(pixel_size, pixelateRadius);
 	vec2 texsize_vec;
 	vec2_set(&texsize_vec, (float)width, (float)height);
@@ -147,17 +455,12 @@ gs_texture_t *pixelate_image(struct filter_data *tf, uint32_t width, uint32_t he
 	struct vec4 background;
 	vec4_zero(&background);
 	gs_clear(GS_CLEAR_COLOR, &background, 0.0f, 0);
-	gs_ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height), -100.0f,
-		 100.0f);
 	gs_blend_state_push();
 	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
 
-	while (gs_effect_loop(tf->pixelateEffect, "Draw")) {
-		gs_draw_sprite(blurredTexture, 0, width, height);
-	}
+	draw_region(tf->pixelateEffect, "Draw", region, width, height);
 	gs_blend_state_pop();
-	gs_texrender_end(tf->texrender);
-	gs_copy_texture(blurredTexture, gs_texrender_get_texture(tf->texrender));
+	gs_texrender_end(tf->pixelateTexrender);
 
-	return blurredTexture;
+	return gs_texrender_get_texture(tf->pixelateTexrender);
 }
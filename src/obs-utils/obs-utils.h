@@ -3,12 +3,29 @@
 
 #include "FilterData.h"
 
+bool begin_texrender(filter_data *tf, gs_texrender_t *texrender, uint32_t width,
+		     uint32_t height);
+
 bool getRGBAFromStageSurface(filter_data *tf, uint32_t &width, uint32_t &height);
 
+// the inference region of a frame of the given size: the crop rectangle or the whole frame
+cv::Rect getCropRect(filter_data *tf, uint32_t width, uint32_t height);
+
+// the part of the frame covered by the mask of the objects: the union of their boxes grown by
+// the dilation and the feathering, clipped to the frame
+cv::Rect get_mask_region(filter_data *tf, uint32_t width, uint32_t height,
+			 const std::vector<Object> &objects);
+
+// rasterize the boxes of the objects into the R8 mask texrender and return its texture
+gs_texture_t *render_box_mask(struct filter_data *tf, uint32_t width, uint32_t height,
+			      const std::vector<Object> &objects, const cv::Rect &region);
+
+// blur_image and pixelate_image only process the region and return textures of the filter,
+// valid until their next call
 gs_texture_t *blur_image(struct filter_data *tf, uint32_t width, uint32_t height,
-			 gs_texture_t *alphaTexture = nullptr);
+			 gs_texture_t *alphaTexture, const cv::Rect &region);
 
 gs_texture_t *pixelate_image(struct filter_data *tf, uint32_t width, uint32_t height,
-			     gs_texture_t *alphaTexture, float pixelateRadius);
+			     const cv::Rect &region, float pixelateRadius);
 
 #endif /* OBS_UTILS_H */
@@ -0,0 +1,118 @@
+#include "BatchScheduler.h"
+
+#include <algorithm>
+#include <cstring>
+
+void BatchScheduler::run(Ort::Session &session, const char *input_name,
+			 const std::vector<const char *> &output_names, Request &request)
+{
+	std::unique_lock<std::mutex> lock(this->mutex_);
+
+	request.enqueued = std::chrono::steady_clock::now();
+	request.done = false;
+	request.error = nullptr;
+	this->pending_.push_back(&request);
+	// the leader may be waiting for the batch to fill up
+	this->condition_.notify_all();
+
+	while (!request.done) {
+		if (this->leader_active_) {
+			this->condition_.wait(lock);
+			continue;
+		}
+
+		// become the leader: wait until the batch is full or the oldest request is due
+		this->leader_active_ = true;
+		size_t batch_size = 1;
+		while (true) {
+			batch_size = this->pending_.size();
+			size_t max_batch_size = batch_size;
+			auto deadline = std::chrono::steady_clock::time_point::max();
+			for (const Request *pending : this->pending_) {
+				const size_t limit = std::max(pending->max_batch_size, (size_t)1);
+				max_batch_size = std::min(max_batch_size, limit);
+				deadline = std::min(deadline,
+						    pending->enqueued + pending->max_wait);
+			}
+			if (batch_size >= max_batch_size) {
+				batch_size = max_batch_size;
+				break;
+			}
+			if (this->condition_.wait_until(lock, deadline) ==
+			    std::cv_status::timeout) {
+				batch_size = std::min(this->pending_.size(), max_batch_size);
+				break;
+			}
+		}
+
+		std::vector<Request *> batch(this->pending_.begin(),
+					     this->pending_.begin() + (std::ptrdiff_t)batch_size);
+		this->pending_.erase(this->pending_.begin(),
+				     this->pending_.begin() + (std::ptrdiff_t)batch_size);
+
+		const auto now = std::chrono::steady_clock::now();
+		for (const Request *batched : batch) {
+			this->queue_delay_total_us_ +=
+				(uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+					now - batched->enqueued)
+					.count();
+		}
+
+		lock.unlock();
+		std::exception_ptr error;
+		try {
+			this->runBatch(session, input_name, output_names, batch);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		lock.lock();
+
+		for (Request *batched : batch) {
+			batched->error = error;
+			batched->done = true;
+		}
+		this->batches_++;
+		this->samples_ += batch.size();
+		this->leader_active_ = false;
+		this->condition_.notify_all();
+	}
+
+	if (request.error) {
+		std::rethrow_exception(request.error);
+	}
+}
+
+void BatchScheduler::runBatch(Ort::Session &session, const char *input_name,
+			      const std::vector<const char *> &output_names,
+			      const std::vector<Request *> &batch)
+{
+	const Request &first = *batch.front();
+	const size_t n = batch.size();
+
+	// pack the samples into one batched input tensor
+	this->batch_input_.resize(first.input_count * n);
+	for (size_t i = 0; i < n; ++i) {
+		memcpy(this->batch_input_.data() + i * first.input_count, batch[i]->input,
+		       first.input_count * sizeof(float));
+	}
+	std::vector<int64_t> shape = first.input_shape;
+	shape[0] = (int64_t)n;
+	auto memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+	Ort::Value input = Ort::Value::CreateTensor<float>(memory_info, this->batch_input_.data(),
+							   this->batch_input_.size(),
+							   shape.data(), shape.size());
+
+	Ort::RunOptions run_options;
+	std::vector<Ort::Value> outputs = session.Run(run_options, &input_name, &input, 1,
+						      output_names.data(), output_names.size());
+
+	// scatter every output back to the requests, sample i is the i-th slice of the batch
+	for (size_t o = 0; o < outputs.size(); ++o) {
+		const float *data = outputs[o].GetTensorData<float>();
+		const size_t count = outputs[o].GetTensorTypeAndShapeInfo().GetElementCount() / n;
+		for (size_t i = 0; i < n; ++i) {
+			memcpy(batch[i]->outputs[o], data + i * count,
+			       std::min(count, batch[i]->output_counts[o]) * sizeof(float));
+		}
+	}
+}
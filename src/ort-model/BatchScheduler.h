@@ -0,0 +1,78 @@
+#ifndef BATCH_SCHEDULER_H
+#define BATCH_SCHEDULER_H
+
+#include <onnxruntime_cxx_api.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Packs single-sample requests from several model users into batched runs
+ *
+ * Used for models exported with a dynamic batch dimension. Requests wait in a queue until
+ * either the batch is full or the oldest request reached its maximal wait time, then the
+ * first waiting caller becomes the leader, runs the whole batch and scatters the outputs back
+ * to every request. There is no scheduler thread, callers block in run() until their sample
+ * has been processed.
+ */
+class BatchScheduler {
+public:
+	struct Request {
+		// one sample of the (single) model input
+		const float *input;
+		size_t input_count;
+		std::vector<int64_t> input_shape; // shape of one sample, batch dimension is 1
+		// one sample of every model output
+		std::vector<float *> outputs;
+		std::vector<size_t> output_counts;
+
+		size_t max_batch_size;
+		std::chrono::microseconds max_wait;
+
+		// filled by the scheduler
+		std::chrono::steady_clock::time_point enqueued;
+		bool done = false;
+		std::exception_ptr error;
+	};
+
+	struct Stats {
+		uint64_t batches;
+		uint64_t samples;
+		uint64_t queue_delay_total_us;
+	};
+
+	// Run the request, possibly batched with requests of other callers. Throws the exception
+	// of the batched run if it failed.
+	void run(Ort::Session &session, const char *input_name,
+		 const std::vector<const char *> &output_names, Request &request);
+
+	Stats stats() const
+	{
+		return {batches_.load(), samples_.load(), queue_delay_total_us_.load()};
+	}
+
+private:
+	void runBatch(Ort::Session &session, const char *input_name,
+		      const std::vector<const char *> &output_names,
+		      const std::vector<Request *> &batch);
+
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	std::deque<Request *> pending_;
+	bool leader_active_ = false;
+
+	// batched input, only touched by the current leader
+	std::vector<float> batch_input_;
+
+	std::atomic<uint64_t> batches_{0};
+	std::atomic<uint64_t> samples_{0};
+	std::atomic<uint64_t> queue_delay_total_us_{0};
+};
+
+#endif // BATCH_SCHEDULER_H
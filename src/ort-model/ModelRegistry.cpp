@@ -0,0 +1,114 @@
+#include "ModelRegistry.h"
+
+#include <filesystem>
+
+#include "plugin-support.h"
+
+#include <obs.h>
+
+ModelRegistry &ModelRegistry::instance()
+{
+	static ModelRegistry registry;
+	return registry;
+}
+
+std::shared_ptr<SharedModel> ModelRegistry::acquire(
+	const ModelKey &key,
+	const std::function<Ort::Session(Ort::Env &env, const ModelKey &key)> &create)
+{
+	std::unique_lock<std::mutex> lock(this->mutex_);
+
+	auto it = this->models_.find(key);
+	if (it != this->models_.end()) {
+		std::shared_ptr<SharedModel> model = it->second.model.lock();
+		if (!model && it->second.pending.valid()) {
+			// another filter is creating the session, wait for it without the lock
+			std::shared_future<std::shared_ptr<SharedModel>> pending =
+				it->second.pending;
+			lock.unlock();
+			model = pending.get();
+		}
+		if (model) {
+			obs_log(LOG_INFO, "Reusing shared model session %s (%s), %ld users",
+				model->name.c_str(), key.device.c_str(), model.use_count() - 1);
+			return model;
+		}
+	}
+
+	// drop the entries of released sessions
+	for (auto entry = this->models_.begin(); entry != this->models_.end();) {
+		if (entry->second.model.expired() && !entry->second.pending.valid()) {
+			entry = this->models_.erase(entry);
+		} else {
+			++entry;
+		}
+	}
+
+	// a placeholder for the callers of the same key while the session is created, which can
+	// take seconds and must not hold up the other models
+	std::promise<std::shared_ptr<SharedModel>> promise;
+	this->models_[key] = {{}, promise.get_future().share()};
+	lock.unlock();
+
+	const std::string name = std::filesystem::path(key.path).filename().u8string();
+	std::shared_ptr<SharedModel> model(new SharedModel(), [](SharedModel *released) {
+		obs_log(LOG_INFO, "Released shared model session %s (%s)",
+			released->name.c_str(), released->key.device.c_str());
+		delete released;
+	});
+	model->key = key;
+	model->name = name;
+	try {
+		model->session = create(this->env_, key);
+	} catch (...) {
+		lock.lock();
+		this->models_.erase(key);
+		lock.unlock();
+		promise.set_exception(std::current_exception());
+		throw;
+	}
+
+	obs_log(LOG_INFO, "Created shared model session %s (%s, %d threads)", name.c_str(),
+		key.device.c_str(), key.intra_op_num_threads);
+
+	lock.lock();
+	this->models_[key] = {model, {}};
+	lock.unlock();
+	promise.set_value(model);
+	return model;
+}
+
+std::vector<ModelRegistry::Usage> ModelRegistry::usage()
+{
+	std::lock_guard<std::mutex> lock(this->mutex_);
+
+	std::vector<Usage> result;
+	for (const auto &[key, entry] : this->models_) {
+		std::shared_ptr<SharedModel> model = entry.model.lock();
+		if (!model) {
+			continue;
+		}
+		// do not count the pointer held for this snapshot
+		result.push_back({model->name, key.device, key.intra_op_num_threads,
+				  model.use_count() - 1, model->runs.load(),
+				  model->scheduler.stats()});
+	}
+	return result;
+}
+
+void ModelRegistry::logUsage()
+{
+	for (const Usage &u : this->usage()) {
+		obs_log(LOG_INFO, "  Model %s (%s, %d threads): %ld users, %llu runs",
+			u.name.c_str(), u.device.c_str(), u.threads, u.users,
+			(unsigned long long)u.runs);
+		if (u.batching.batches > 0) {
+			obs_log(LOG_INFO,
+				"    %llu batched runs, avg batch %.2f, avg queue delay %.2f ms",
+				(unsigned long long)u.batching.batches,
+				(double)u.batching.samples / (double)u.batching.batches,
+				(double)u.batching.queue_delay_total_us /
+					(double)u.batching.samples / 1000.0);
+		}
+	}
+}
@@ -0,0 +1,101 @@
+#ifndef MODEL_REGISTRY_H
+#define MODEL_REGISTRY_H
+
+#include <onnxruntime_cxx_api.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "types.hpp"
+#include "BatchScheduler.h"
+
+/**
+ * @brief Everything that makes two ORT sessions interchangeable
+ */
+struct ModelKey {
+	file_name_t path;
+	std::string device;
+	int device_id;
+	int intra_op_num_threads;
+	int inter_op_num_threads;
+	bool use_parallel;
+
+	bool operator<(const ModelKey &other) const
+	{
+		return std::tie(path, device, device_id, intra_op_num_threads,
+				inter_op_num_threads, use_parallel) <
+		       std::tie(other.path, other.device, other.device_id,
+				other.intra_op_num_threads, other.inter_op_num_threads,
+				other.use_parallel);
+	}
+};
+
+/**
+ * @brief An ORT session shared by all the model instances with the same ModelKey
+ *
+ * Ort::Session::Run is safe to call concurrently, each user keeps its own input and output
+ * buffers.
+ */
+struct SharedModel {
+	ModelKey key;
+	std::string name;
+	Ort::Session session{nullptr};
+	std::atomic<uint64_t> runs{0};
+	// batches requests of the users for models with a dynamic batch dimension
+	BatchScheduler scheduler;
+};
+
+/**
+ * @brief Process-wide registry of shared ORT sessions
+ *
+ * Sessions are reference counted through the returned shared pointers and released when the
+ * last user lets go of them. All sessions use the single ORT environment of the registry.
+ */
+class ModelRegistry {
+public:
+	struct Usage {
+		std::string name;
+		std::string device;
+		int threads;
+		long users;
+		uint64_t runs;
+		BatchScheduler::Stats batching;
+	};
+
+	static ModelRegistry &instance();
+
+	// Get the session for the key, creating it with `create` if nobody uses it yet. The
+	// session is created outside the registry lock, callers asking for the same key meanwhile
+	// wait for it. Exceptions thrown by `create` are passed on to all of them.
+	std::shared_ptr<SharedModel>
+	acquire(const ModelKey &key,
+		const std::function<Ort::Session(Ort::Env &env, const ModelKey &key)> &create);
+
+	// Snapshot of the sessions currently alive and how many instances share each
+	std::vector<Usage> usage();
+
+	void logUsage();
+
+private:
+	struct Entry {
+		std::weak_ptr<SharedModel> model;
+		// valid while the session is being created
+		std::shared_future<std::shared_ptr<SharedModel>> pending;
+	};
+
+	ModelRegistry() = default;
+
+	Ort::Env env_{ORT_LOGGING_LEVEL_WARNING, "Default"};
+	std::mutex mutex_;
+	std::map<ModelKey, Entry> models_;
+};
+
+#endif // MODEL_REGISTRY_H
@@ -5,9 +5,134 @@
 #endif
 
 #include "plugin-support.h"
+#include "preprocess.h"
+#include "model-cache.h"
 
 #include <obs.h>
 
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+
+static size_t element_count(const std::vector<int64_t> &shape)
+{
+	size_t count = 1;
+	for (int64_t dim : shape) {
+		count *= (size_t)dim;
+	}
+	return count;
+}
+
+static Ort::SessionOptions create_session_options(const ModelKey &key,
+						   GraphOptimizationLevel optimization_level)
+{
+	Ort::SessionOptions session_options;
+
+	session_options.SetGraphOptimizationLevel(optimization_level);
+	if (key.use_parallel) {
+		session_options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+		session_options.SetInterOpNumThreads(key.inter_op_num_threads);
+	} else {
+		session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+	}
+	session_options.SetIntraOpNumThreads(key.intra_op_num_threads);
+
+#ifdef _WIN32
+	if (key.device == "cuda") {
+		OrtCUDAProviderOptions cuda_option;
+		cuda_option.device_id = key.device_id;
+		session_options.AppendExecutionProvider_CUDA(cuda_option);
+	}
+	if (key.device == "dml") {
+		auto &api = Ort::GetApi();
+		OrtDmlApi *dmlApi = nullptr;
+		Ort::ThrowOnError(api.GetExecutionProviderApi("DML", ORT_API_VERSION,
+							      (const void **)&dmlApi));
+		Ort::ThrowOnError(
+			dmlApi->SessionOptionsAppendExecutionProvider_DML(session_options, 0));
+	}
+#endif
+
+	return session_options;
+}
+
+/**
+ * @brief Write the optimized graph of the model to the cache
+ *
+ * ORT writes the optimized model while creating a session, the session itself is not used.
+ * Only the optimizations up to ORT_ENABLE_EXTENDED are stored, they are the same on every
+ * CPU. The layout optimizations of ORT_ENABLE_ALL depend on the instruction sets of the CPU,
+ * they are applied when the cached model is loaded.
+ */
+static bool store_optimized_model(Ort::Env &env, const ModelKey &key,
+				  const std::filesystem::path &cache_path)
+{
+	// write the file next to the final path and rename, a partial file is never loaded
+	std::filesystem::path cache_tmp_path = cache_path;
+	cache_tmp_path += ".tmp";
+	Ort::SessionOptions session_options =
+		create_session_options(key, GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
+	session_options.SetOptimizedModelFilePath(cache_tmp_path.c_str());
+
+	std::error_code error;
+	try {
+		Ort::Session session(env, key.path.c_str(), session_options);
+	} catch (const Ort::Exception &e) {
+		obs_log(LOG_WARNING, "Failed to optimize the model for the cache: %s", e.what());
+		std::filesystem::remove(cache_tmp_path, error);
+		return false;
+	}
+	std::filesystem::rename(cache_tmp_path, cache_path, error);
+	if (error) {
+		obs_log(LOG_WARNING, "Failed to store the optimized model: %s",
+			error.message().c_str());
+		std::filesystem::remove(cache_tmp_path, error);
+		return false;
+	}
+	prune_optimized_model_cache(cache_path);
+	return true;
+}
+
+static Ort::Session create_session(Ort::Env &env, const ModelKey &key)
+{
+	const auto start = std::chrono::steady_clock::now();
+	auto elapsed_ms = [&start]() {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+								 start)
+			.count();
+	};
+
+	const std::filesystem::path cache_path = optimized_model_cache_path(key);
+	std::error_code error;
+	bool cache_hit = !cache_path.empty() && std::filesystem::exists(cache_path, error);
+	if (!cache_path.empty() && !cache_hit && store_optimized_model(env, key, cache_path)) {
+		obs_log(LOG_INFO, "Optimized model cached in %.0f ms", elapsed_ms());
+		cache_hit = true;
+	}
+	if (cache_hit) {
+		// the cached model is already optimized, only the CPU specific optimizations
+		// are left to do
+		try {
+			Ort::Session session(env, cache_path.c_str(),
+					     create_session_options(
+						     key, GraphOptimizationLevel::ORT_ENABLE_ALL));
+			obs_log(LOG_INFO, "Model session created in %.0f ms (optimized model cache)",
+				elapsed_ms());
+			return session;
+		} catch (const Ort::Exception &e) {
+			obs_log(LOG_WARNING, "Discarding unusable optimized model cache: %s",
+				e.what());
+			std::filesystem::remove(cache_path, error);
+		}
+	}
+
+	Ort::Session session(env, key.path.c_str(),
+			     create_session_options(key, GraphOptimizationLevel::ORT_ENABLE_ALL));
+	obs_log(LOG_INFO, "Model session created in %.0f ms (optimized model cache not used)",
+		elapsed_ms());
+	return session;
+}
+
 ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_threads,
 				   int num_classes, int inter_op_num_threads,
 				   const std::string &use_gpu_, int device_id, bool use_parallel,
@@ -21,59 +146,50 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 	  bbox_conf_thresh_(conf_th),
 	  num_classes_(num_classes)
 {
+	// filters with the same model and session options share one session, each keeps its own
+	// input and output buffers below
+	ModelKey key;
+	key.path = path_to_model;
+	key.device = this->use_gpu;
+	key.device_id = this->device_id_;
+	key.intra_op_num_threads = this->intra_op_num_threads_;
+	key.inter_op_num_threads = this->inter_op_num_threads_;
+	key.use_parallel = this->use_parallel_;
 	try {
-		Ort::SessionOptions session_options;
-
-		session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-		if (this->use_parallel_) {
-			session_options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
-			session_options.SetInterOpNumThreads(this->inter_op_num_threads_);
-		} else {
-			session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
-		}
-		session_options.SetIntraOpNumThreads(this->intra_op_num_threads_);
-
-#ifdef _WIN32
-		if (this->use_gpu == "cuda") {
-			OrtCUDAProviderOptions cuda_option;
-			cuda_option.device_id = this->device_id_;
-			session_options.AppendExecutionProvider_CUDA(cuda_option);
-		}
-		if (this->use_gpu == "dml") {
-			auto &api = Ort::GetApi();
-			OrtDmlApi *dmlApi = nullptr;
-			Ort::ThrowOnError(api.GetExecutionProviderApi("DML", ORT_API_VERSION,
-								      (const void **)&dmlApi));
-			Ort::ThrowOnError(dmlApi->SessionOptionsAppendExecutionProvider_DML(
-				session_options, 0));
-		}
-#endif
-
-		this->session_ = Ort::Session(this->env_, path_to_model.c_str(), session_options);
+		this->model_ = ModelRegistry::instance().acquire(key, create_session);
 	} catch (std::exception &e) {
 		obs_log(LOG_ERROR, "Cannot load model: %s", e.what());
-		throw e;
+		throw;
 	}
+	Ort::Session &session = this->model_->session;
 
 	Ort::AllocatorWithDefaultOptions ort_alloc;
 
 	// number of inputs
-	size_t num_input = this->session_.GetInputCount();
+	size_t num_input = session.GetInputCount();
 
 	for (size_t i = 0; i < num_input; i++) {
-		auto input_info = this->session_.GetInputTypeInfo(i);
+		auto input_info = session.GetInputTypeInfo(i);
 		auto input_shape_info = input_info.GetTensorTypeAndShapeInfo();
 		auto input_shape = input_shape_info.GetShape();
 		auto input_tensor_type = input_shape_info.GetElementType();
 
+		// a dynamic batch dimension gets buffers for a single sample, several samples are
+		// only packed together by the batch scheduler
+		if (!input_shape.empty() && input_shape[0] < 0) {
+			input_shape[0] = 1;
+			this->dynamic_batch_ = true;
+		}
+		this->input_shapes_.push_back(input_shape);
+
 		// assume input shape is NCHW
 		this->input_h_.push_back((int)(input_shape[2]));
 		this->input_w_.push_back((int)(input_shape[3]));
 
 		// Allocate input memory buffer
 		this->input_name_.push_back(
-			std::string(this->session_.GetInputNameAllocated(i, ort_alloc).get()));
-		size_t input_byte_count = sizeof(float) * input_shape_info.GetElementCount();
+			std::string(session.GetInputNameAllocated(i, ort_alloc).get()));
+		size_t input_byte_count = sizeof(float) * element_count(input_shape);
 		std::unique_ptr<uint8_t[]> input_buffer =
 			std::make_unique<uint8_t[]>(input_byte_count);
 		auto input_memory_info =
@@ -91,19 +207,25 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 			input_shape.size() > 3 ? input_shape[3] : 0);
 	}
 
+	obs_log(LOG_INFO, "Preprocessing kernel: %s", letterbox_kernel_name());
+	obs_log(LOG_INFO, "Dynamic batch: %s", this->dynamic_batch_ ? "yes" : "no");
+
 	// number of outputs
-	size_t num_output = this->session_.GetOutputCount();
+	size_t num_output = session.GetOutputCount();
 
 	for (size_t i = 0; i < num_output; i++) {
-		auto output_info = this->session_.GetOutputTypeInfo(i);
+		auto output_info = session.GetOutputTypeInfo(i);
 		auto output_shape_info = output_info.GetTensorTypeAndShapeInfo();
 		auto output_shape = output_shape_info.GetShape();
 		auto output_tensor_type = output_shape_info.GetElementType();
 
+		if (!output_shape.empty() && output_shape[0] < 0) {
+			output_shape[0] = 1;
+		}
 		this->output_shapes_.push_back(output_shape);
 
 		// Allocate output memory buffer
-		size_t output_byte_count = sizeof(float) * output_shape_info.GetElementCount();
+		size_t output_byte_count = sizeof(float) * element_count(output_shape);
 		std::unique_ptr<uint8_t[]> output_buffer =
 			std::make_unique<uint8_t[]>(output_byte_count);
 		auto output_memory_info =
@@ -115,7 +237,7 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 		this->output_buffer_.push_back(std::move(output_buffer));
 
 		this->output_name_.push_back(
-			std::string(this->session_.GetOutputNameAllocated(i, ort_alloc).get()));
+			std::string(session.GetOutputNameAllocated(i, ort_alloc).get()));
 
 		obs_log(LOG_INFO, "Output name: %s", this->output_name_[i].c_str());
 		obs_log(LOG_INFO, "Output shape: %d %d %d %d", output_shape[0],
@@ -125,146 +247,91 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 	}
 }
 
-cv::Mat ONNXRuntimeModel::static_resize(const cv::Mat &img, const int input_index)
+void ONNXRuntimeModel::inference(const cv::Mat &frame, const int input_index)
 {
-	float r = std::fminf((float)input_w_[input_index] / (float)img.cols,
-			     (float)input_h_[input_index] / (float)img.rows);
-	// r = std::min(r, 1.0f);
-	int unpad_w = (int)(r * (float)img.cols);
-	int unpad_h = (int)(r * (float)img.rows);
-	cv::Mat re(unpad_h, unpad_w, CV_8UC3);
-	cv::resize(img, re, re.size());
-	cv::Mat out(input_h_[input_index], input_w_[input_index], CV_8UC3,
-		    cv::Scalar(114, 114, 114));
-	re.copyTo(out(cv::Rect(0, 0, re.cols, re.rows)));
-	return out;
-}
+	// preprocess: letterbox resize the BGR(A) frame straight into the NCHW input buffer
+	float *blob_data = (float *)(this->input_buffer_[input_index].get());
+	letterbox_to_blob(frame.data, frame.cols, frame.rows, frame.step[0], frame.channels(),
+			  blob_data, input_w_[input_index], input_h_[input_index]);
 
-// for NCHW
-void ONNXRuntimeModel::blobFromImage(const cv::Mat &img, float *blob_data)
-{
-	size_t channels = 3;
-	size_t img_h = img.rows;
-	size_t img_w = img.cols;
-	for (size_t c = 0; c < channels; ++c) {
-		for (size_t h = 0; h < img_h; ++h) {
-			for (size_t w = 0; w < img_w; ++w) {
-				blob_data[(int)(c * img_w * img_h + h * img_w + w)] =
-					(float)img.ptr<cv::Vec3b>((int)h)[(int)w][(int)c];
-			}
-		}
+	// input names
+	std::vector<const char *> input_names;
+	for (size_t i = 0; i < this->input_name_.size(); i++) {
+		input_names.push_back(this->input_name_[i].c_str());
 	}
-}
 
-// for NHWC
-void ONNXRuntimeModel::blobFromImage_nhwc(const cv::Mat &img, float *blob_data)
-{
-	size_t channels = 3;
-	size_t img_h = img.rows;
-	size_t img_w = img.cols;
-	for (size_t i = 0; i < img_h * img_w; ++i) {
-		for (size_t c = 0; c < channels; ++c) {
-			blob_data[i * channels + c] = (float)img.data[i * channels + c];
-		}
+	// output names
+	std::vector<const char *> output_names;
+	for (size_t i = 0; i < this->output_name_.size(); i++) {
+		output_names.push_back(this->output_name_[i].c_str());
 	}
-}
-
-float ONNXRuntimeModel::intersection_area(const Object &a, const Object &b)
-{
-	cv::Rect_<float> inter = a.rect & b.rect;
-	return inter.area();
-}
-
-void ONNXRuntimeModel::qsort_descent_inplace(std::vector<Object> &faceobjects, int left, int right)
-{
-	int i = left;
-	int j = right;
-	float p = faceobjects[(left + right) / 2].prob;
 
-	while (i <= j) {
-		while (faceobjects[i].prob > p)
-			++i;
-
-		while (faceobjects[j].prob < p)
-			--j;
-
-		if (i <= j) {
-			std::swap(faceobjects[i], faceobjects[j]);
-
-			++i;
-			--j;
+	// Inference
+	if (this->dynamic_batch_ && this->batch_max_size_ > 1 && this->input_tensor_.size() == 1) {
+		// batch with the other users of the shared session
+		BatchScheduler::Request request;
+		request.input = blob_data;
+		request.input_count = element_count(this->input_shapes_[0]);
+		request.input_shape = this->input_shapes_[0];
+		for (size_t i = 0; i < this->output_buffer_.size(); i++) {
+			request.outputs.push_back((float *)this->output_buffer_[i].get());
+			request.output_counts.push_back(element_count(this->output_shapes_[i]));
 		}
+		request.max_batch_size = this->batch_max_size_;
+		request.max_wait = this->batch_max_wait_;
+		this->model_->scheduler.run(this->model_->session, input_names[0], output_names,
+					    request);
+	} else {
+		Ort::RunOptions run_options;
+		this->model_->session.Run(run_options, input_names.data(),
+					  this->input_tensor_.data(), this->input_tensor_.size(),
+					  output_names.data(), this->output_tensor_.data(),
+					  this->output_tensor_.size());
 	}
-	if (left < j)
-		qsort_descent_inplace(faceobjects, left, j);
-	if (i < right)
-		qsort_descent_inplace(faceobjects, i, right);
-}
-
-void ONNXRuntimeModel::qsort_descent_inplace(std::vector<Object> &objects)
-{
-	if (objects.empty())
-		return;
-
-	qsort_descent_inplace(objects, 0, (int)(objects.size() - 1));
+	this->model_->runs++;
 }
 
-void ONNXRuntimeModel::nms_sorted_bboxes(const std::vector<Object> &objects,
-					 std::vector<int> &picked, const float nms_threshold)
+std::vector<std::vector<Object>>
+ONNXRuntimeModel::inferenceBatch(const std::vector<cv::Mat> &frames,
+				 const DetectionQuery &query)
 {
-	picked.clear();
-
-	const size_t n = objects.size();
-
-	std::vector<float> areas(n);
-	for (size_t i = 0; i < n; ++i) {
-		areas[i] = objects[i].rect.area();
-	}
-
-	for (size_t i = 0; i < n; ++i) {
-		const Object &a = objects[i];
-		const size_t picked_size = picked.size();
-
-		int keep = 1;
-		for (size_t j = 0; j < picked_size; ++j) {
-			const Object &b = objects[picked[j]];
-
-			// intersection over union
-			float inter_area = this->intersection_area(a, b);
-			float union_area = areas[i] + areas[picked[j]] - inter_area;
-			// float IoU = inter_area / union_area
-			if (inter_area / union_area > nms_threshold)
-				keep = 0;
-		}
-
-		if (keep)
-			picked.push_back((int)i);
+	std::vector<std::vector<Object>> results;
+	results.reserve(frames.size());
+	for (const cv::Mat &frame : frames) {
+		results.push_back(this->inference(frame, query));
 	}
+	return results;
 }
 
-void ONNXRuntimeModel::inference(const cv::Mat &frame, const int input_index)
+std::vector<Ort::Value> ONNXRuntimeModel::runBatch(const std::vector<cv::Mat> &frames)
 {
-	// preprocess
-	cv::Mat pr_img = this->static_resize(frame, input_index);
-
-	float *blob_data = (float *)(this->input_buffer_[input_index].get());
-	blobFromImage(pr_img, blob_data);
-
-	// input names
-	std::vector<const char *> input_names;
-	for (size_t i = 0; i < this->input_name_.size(); i++) {
-		input_names.push_back(this->input_name_[i].c_str());
+	// preprocess every frame into its slice of the batched input
+	const size_t sample_count = element_count(this->input_shapes_[0]);
+	this->batch_input_.resize(sample_count * frames.size());
+	for (size_t i = 0; i < frames.size(); i++) {
+		const cv::Mat &frame = frames[i];
+		letterbox_to_blob(frame.data, frame.cols, frame.rows, frame.step[0],
+				  frame.channels(), this->batch_input_.data() + i * sample_count,
+				  input_w_[0], input_h_[0]);
 	}
 
-	// output names
+	std::vector<int64_t> shape = this->input_shapes_[0];
+	shape[0] = (int64_t)frames.size();
+	auto memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+	Ort::Value input = Ort::Value::CreateTensor<float>(memory_info, this->batch_input_.data(),
+							   this->batch_input_.size(),
+							   shape.data(), shape.size());
+
+	const char *input_name = this->input_name_[0].c_str();
 	std::vector<const char *> output_names;
 	for (size_t i = 0; i < this->output_name_.size(); i++) {
 		output_names.push_back(this->output_name_[i].c_str());
 	}
 
-	// Inference
 	Ort::RunOptions run_options;
-	this->session_.Run(run_options, input_names.data(), this->input_tensor_.data(),
-			   this->input_tensor_.size(), output_names.data(),
-			   this->output_tensor_.data(), this->output_tensor_.size());
+	std::vector<Ort::Value> outputs =
+		this->model_->session.Run(run_options, &input_name, &input, 1,
+					  output_names.data(), output_names.size());
+	this->model_->runs++;
+	return outputs;
 }
@@ -4,12 +4,17 @@
 #include <opencv2/core/types.hpp>
 #include <onnxruntime_cxx_api.h>
 
+#include <algorithm>
+#include <chrono>
 #include <vector>
 #include <array>
+#include <memory>
 #include <string>
 #include <tuple>
 
 #include "types.hpp"
+#include "ModelRegistry.h"
+#include "nms/nms.h"
 
 // Generic class for ONNXRuntime models
 class ONNXRuntimeModel {
@@ -26,25 +31,58 @@ public:
 
 	void setBBoxConfThresh(float thresh) { this->bbox_conf_thresh_ = thresh; }
 	void setNmsThresh(float thresh) { this->nms_thresh_ = thresh; }
+	// "agnostic", "class_aware" or "soft" (class-aware Gaussian Soft-NMS)
+	void setNmsMode(const std::string &mode)
+	{
+		this->nms_class_aware_ = mode == "class_aware" || mode == "soft";
+		this->nms_soft_ = mode == "soft";
+	}
+	// Batch requests with other users of the same session, only for models with a dynamic
+	// batch dimension. A maximal batch size of 1 disables batching.
+	void setBatching(int max_batch_size, int max_wait_ms)
+	{
+		this->batch_max_size_ = (size_t)std::max(max_batch_size, 1);
+		this->batch_max_wait_ = std::chrono::milliseconds(std::max(max_wait_ms, 0));
+	}
 
-	virtual std::vector<Object> inference(const cv::Mat &frame) = 0;
+	// Detect the objects in the frame that match the query
+	virtual std::vector<Object> inference(const cv::Mat &frame,
+					      const DetectionQuery &query = DetectionQuery()) = 0;
+
+	// Run inference on several frames. Models with a dynamic batch dimension may run them as
+	// one batch, the default runs them one after the other.
+	virtual std::vector<std::vector<Object>>
+	inferenceBatch(const std::vector<cv::Mat> &frames,
+		       const DetectionQuery &query = DetectionQuery());
+
+	// native resolution of the (first) model input
+	cv::Size inputSize() const { return cv::Size(this->input_w_[0], this->input_h_[0]); }
 
 protected:
-	cv::Mat static_resize(const cv::Mat &img, const int input_index);
-	void blobFromImage(const cv::Mat &img, float *blob_data);
-	void blobFromImage_nhwc(const cv::Mat &img, float *blob_data);
-	float intersection_area(const Object &a, const Object &b);
-	void qsort_descent_inplace(std::vector<Object> &faceobjects, int left, int right);
-	void qsort_descent_inplace(std::vector<Object> &objects);
-	void nms_sorted_bboxes(const std::vector<Object> &objects, std::vector<int> &picked,
-			       const float nms_threshold);
+	// NMS options from the thresholds and the NMS mode of the model
+	NmsOptions nmsOptions() const
+	{
+		NmsOptions options;
+		options.iouThreshold = this->nms_thresh_;
+		options.classAware = this->nms_class_aware_;
+		options.soft = this->nms_soft_;
+		options.scoreThreshold = this->bbox_conf_thresh_;
+		return options;
+	}
 
-	// run inference on the model with the given frame that should go in the input index
+	// run inference on the model with the given 8-bit BGR or BGRA frame that should go in the
+	// input index
 	void inference(const cv::Mat &frame, const int input_index);
 
+	// run the frames as one batch through the single input of a model with a dynamic batch
+	// dimension, returns the batched outputs allocated by ORT
+	std::vector<Ort::Value> runBatch(const std::vector<cv::Mat> &frames);
+
 	std::vector<int> input_w_;
 	std::vector<int> input_h_;
 	float nms_thresh_;
+	bool nms_class_aware_ = false;
+	bool nms_soft_ = false;
 	float bbox_conf_thresh_;
 	int num_classes_;
 	bool use_parallel_;
@@ -55,8 +93,8 @@ protected:
 	const std::vector<float> mean_ = {0.485f, 0.456f, 0.406f};
 	const std::vector<float> std_ = {0.229f, 0.224f, 0.225f};
 
-	Ort::Session session_{nullptr};
-	Ort::Env env_{ORT_LOGGING_LEVEL_WARNING, "Default"};
+	// session shared with the other instances of the same model, see ModelRegistry
+	std::shared_ptr<SharedModel> model_;
 
 	std::vector<Ort::Value> input_tensor_;
 	std::vector<Ort::Value> output_tensor_;
@@ -64,7 +102,12 @@ protected:
 	std::vector<std::string> output_name_;
 	std::vector<std::unique_ptr<uint8_t[]>> input_buffer_;
 	std::vector<std::unique_ptr<uint8_t[]>> output_buffer_;
+	std::vector<Ort::ShapeInferContext::Ints> input_shapes_;
 	std::vector<Ort::ShapeInferContext::Ints> output_shapes_;
+	bool dynamic_batch_ = false;
+	size_t batch_max_size_ = 1;
+	std::chrono::microseconds batch_max_wait_{0};
+	std::vector<float> batch_input_;
 };
 
 #endif // ONNXRUNTIME_MODEL_H
@@ -0,0 +1,113 @@
+#include "model-cache.h"
+
+#include <onnxruntime_cxx_api.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "plugin-support.h"
+
+#include <obs-module.h>
+
+// FNV-1a, plenty to tell model files and option sets apart
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+static bool hash_file(const std::filesystem::path &path, uint64_t &hash)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+	std::vector<char> chunk(1 << 16);
+	while (file) {
+		file.read(chunk.data(), (std::streamsize)chunk.size());
+		hash = fnv1a(hash, chunk.data(), (size_t)file.gcount());
+	}
+	return true;
+}
+
+// the stored graph only has the optimizations up to ORT_ENABLE_EXTENDED, which do not
+// depend on the CPU, see store_optimized_model
+static const char *const CACHED_OPTIMIZATION_LEVEL = "extended";
+
+static const char *const CACHE_FILE_SUFFIX = ".optimized.onnx";
+
+std::filesystem::path optimized_model_cache_path(const ModelKey &key)
+{
+	if (key.device != "cpu") {
+		return {};
+	}
+
+	const std::filesystem::path model_path(key.path);
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	if (!hash_file(model_path, hash)) {
+		return {};
+	}
+	// the thread and execution mode options do not change the optimized graph
+	const std::string options = std::string(Ort::GetVersionString()) + "|" + key.device + "|" +
+				    CACHED_OPTIMIZATION_LEVEL;
+	hash = fnv1a(hash, options.data(), options.size());
+	// copies of the same model path share the prefix of the file name, see
+	// prune_optimized_model_cache
+	const std::string path_str = std::filesystem::absolute(model_path).u8string();
+	const uint32_t path_hash =
+		(uint32_t)fnv1a(0xcbf29ce484222325ULL, path_str.data(), path_str.size());
+
+	char *cache_folder_rawPtr = obs_module_config_path("model-cache");
+	if (cache_folder_rawPtr == nullptr) {
+		return {};
+	}
+	const std::filesystem::path cache_folder = std::filesystem::u8path(cache_folder_rawPtr);
+	bfree(cache_folder_rawPtr);
+
+	std::error_code error;
+	std::filesystem::create_directories(cache_folder, error);
+	if (error) {
+		obs_log(LOG_WARNING, "Cannot create the model cache folder: %s",
+			error.message().c_str());
+		return {};
+	}
+
+	char hash_str[26];
+	snprintf(hash_str, sizeof(hash_str), "%08" PRIx32 "-%016" PRIx64, path_hash, hash);
+	return cache_folder / std::filesystem::u8path(model_path.stem().u8string() + "-" +
+						      hash_str + CACHE_FILE_SUFFIX);
+}
+
+void prune_optimized_model_cache(const std::filesystem::path &cache_path)
+{
+	// "<model>-<path hash>-" is shared by all the copies of the model path
+	const std::string name = cache_path.filename().u8string();
+	const size_t hash_start = name.rfind('-');
+	if (hash_start == std::string::npos) {
+		return;
+	}
+	const std::string prefix = name.substr(0, hash_start + 1);
+
+	std::error_code error;
+	std::filesystem::directory_iterator entry(cache_path.parent_path(), error);
+	for (; !error && entry != std::filesystem::directory_iterator(); entry.increment(error)) {
+		const std::string entry_name = entry->path().filename().u8string();
+		if (entry_name == name || entry_name.compare(0, prefix.size(), prefix) != 0 ||
+		    entry_name.find(CACHE_FILE_SUFFIX) == std::string::npos) {
+			continue;
+		}
+		// also the .tmp files of stores that did not finish
+		std::error_code remove_error;
+		if (std::filesystem::remove(entry->path(), remove_error)) {
+			obs_log(LOG_INFO, "Removed stale optimized model %s", entry_name.c_str());
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include <filesystem>
+
+#include "ModelRegistry.h"
+
+/**
+ * @brief Location of the ORT-optimized copy of a model in the module config folder
+ *
+ * The file name carries a hash of the model path and a hash of the model file contents and
+ * the ORT version, so a cached model is never used once either changed. Only models for the
+ * CPU execution provider are cached: a graph optimized for CUDA or DirectML contains provider
+ * specific nodes that do not reload reliably.
+ *
+ * @return The cache file path, or an empty path if the model cannot be cached
+ */
+std::filesystem::path optimized_model_cache_path(const ModelKey &key);
+
+/**
+ * @brief Delete the cached copies of the same model path other than `cache_path`
+ *
+ * Called after storing a new copy, so that updating a model file or ORT does not leave the
+ * previous copies behind in the cache folder.
+ */
+void prune_optimized_model_cache(const std::filesystem::path &cache_path);
+
+#endif // MODEL_CACHE_H
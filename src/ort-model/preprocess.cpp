@@ -0,0 +1,486 @@
+#include "preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PREPROCESS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PREPROCESS_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+LetterboxInfo letterbox_info(int src_w, int src_h, int dst_w, int dst_h)
+{
+	LetterboxInfo info;
+	info.scale = std::fminf((float)dst_w / (float)src_w, (float)dst_h / (float)src_h);
+	info.resized_w = std::min(std::max((int)(info.scale * (float)src_w), 1), dst_w);
+	info.resized_h = std::min(std::max((int)(info.scale * (float)src_h), 1), dst_h);
+	return info;
+}
+
+namespace {
+
+// Bilinear taps for one axis, using the pixel center alignment of cv::resize INTER_LINEAR.
+// The first tap is kept one pixel away from the far border so that both taps can always be
+// read, a sample on the last pixel becomes the second tap with full weight.
+void compute_taps(int src_size, int dst_size, int *ofs, float *weight)
+{
+	const double scale = (double)src_size / (double)dst_size;
+	for (int d = 0; d < dst_size; ++d) {
+		float f = (float)(((double)d + 0.5) * scale - 0.5);
+		int s = (int)std::floor(f);
+		f -= (float)s;
+		if (s < 0) {
+			s = 0;
+			f = 0.0f;
+		}
+		if (s >= src_size - 1) {
+			s = std::max(src_size - 2, 0);
+			f = src_size > 1 ? 1.0f : 0.0f;
+		}
+		ofs[d] = s;
+		weight[d] = f;
+	}
+}
+
+inline float lerp(float a, float b, float t)
+{
+	return a + (b - a) * t;
+}
+
+inline uint32_t load_u32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+// Fill one row of the NCHW planes with the bilinear samples of `count` pixels, starting at
+// output pixel `x`. Shared by the scalar path and the tails of the SIMD kernels.
+inline void row_bgra_scalar(const uint8_t *row0, const uint8_t *row1, const int *xofs,
+			    const float *xw, float wy, int x, int count, float *b, float *g,
+			    float *r)
+{
+	for (; x < count; ++x) {
+		const uint8_t *p00 = row0 + xofs[x];
+		const uint8_t *p10 = row1 + xofs[x];
+		const float wx = xw[x];
+		float out[3];
+		for (int c = 0; c < 3; ++c) {
+			const float top = lerp((float)p00[c], (float)p00[c + 4], wx);
+			const float bottom = lerp((float)p10[c], (float)p10[c + 4], wx);
+			out[c] = lerp(top, bottom, wy);
+		}
+		b[x] = out[0];
+		g[x] = out[1];
+		r[x] = out[2];
+	}
+}
+
+typedef int (*row_kernel_t)(const uint8_t *row0, const uint8_t *row1, const int *xofs,
+			    const float *xw, float wy, int count, float *b, float *g, float *r);
+
+#if defined(PREPROCESS_X86)
+
+template<int Shift> TARGET_SSE41 inline __m128 channel_sse41(__m128i pixels)
+{
+	const __m128i byte_mask = _mm_set1_epi32(0xff);
+	return _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, Shift), byte_mask));
+}
+
+template<int Shift>
+TARGET_SSE41 inline __m128 sample_sse41(__m128i p00, __m128i p01, __m128i p10, __m128i p11,
+					__m128 wx, __m128 wy)
+{
+	const __m128 a = channel_sse41<Shift>(p00);
+	const __m128 top = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(channel_sse41<Shift>(p01), a), wx));
+	const __m128 c = channel_sse41<Shift>(p10);
+	const __m128 bottom =
+		_mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(channel_sse41<Shift>(p11), c), wx));
+	return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), wy));
+}
+
+TARGET_SSE41 int row_bgra_sse41(const uint8_t *row0, const uint8_t *row1, const int *xofs,
+				const float *xw, float wy, int count, float *b, float *g, float *r)
+{
+	const __m128 vwy = _mm_set1_ps(wy);
+	int x = 0;
+	for (; x + 4 <= count; x += 4) {
+		const int *o = xofs + x;
+		// gather the four taps of four output pixels, one packed BGRA pixel per lane
+		const __m128i p00 =
+			_mm_setr_epi32((int)load_u32(row0 + o[0]), (int)load_u32(row0 + o[1]),
+				       (int)load_u32(row0 + o[2]), (int)load_u32(row0 + o[3]));
+		const __m128i p01 = _mm_setr_epi32(
+			(int)load_u32(row0 + o[0] + 4), (int)load_u32(row0 + o[1] + 4),
+			(int)load_u32(row0 + o[2] + 4), (int)load_u32(row0 + o[3] + 4));
+		const __m128i p10 =
+			_mm_setr_epi32((int)load_u32(row1 + o[0]), (int)load_u32(row1 + o[1]),
+				       (int)load_u32(row1 + o[2]), (int)load_u32(row1 + o[3]));
+		const __m128i p11 = _mm_setr_epi32(
+			(int)load_u32(row1 + o[0] + 4), (int)load_u32(row1 + o[1] + 4),
+			(int)load_u32(row1 + o[2] + 4), (int)load_u32(row1 + o[3] + 4));
+		const __m128 wx = _mm_loadu_ps(xw + x);
+
+		_mm_storeu_ps(b + x, sample_sse41<0>(p00, p01, p10, p11, wx, vwy));
+		_mm_storeu_ps(g + x, sample_sse41<8>(p00, p01, p10, p11, wx, vwy));
+		_mm_storeu_ps(r + x, sample_sse41<16>(p00, p01, p10, p11, wx, vwy));
+	}
+	row_bgra_scalar(row0, row1, xofs, xw, wy, x, count, b, g, r);
+	return count;
+}
+
+template<int Shift> TARGET_AVX2 inline __m256 channel_avx2(__m256i pixels)
+{
+	const __m256i byte_mask = _mm256_set1_epi32(0xff);
+	return _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixels, Shift), byte_mask));
+}
+
+template<int Shift>
+TARGET_AVX2 inline __m256 sample_avx2(__m256i p00, __m256i p01, __m256i p10, __m256i p11,
+				      __m256 wx, __m256 wy)
+{
+	const __m256 a = channel_avx2<Shift>(p00);
+	const __m256 top =
+		_mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(channel_avx2<Shift>(p01), a), wx));
+	const __m256 c = channel_avx2<Shift>(p10);
+	const __m256 bottom =
+		_mm256_add_ps(c, _mm256_mul_ps(_mm256_sub_ps(channel_avx2<Shift>(p11), c), wx));
+	return _mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), wy));
+}
+
+TARGET_AVX2 int row_bgra_avx2(const uint8_t *row0, const uint8_t *row1, const int *xofs,
+			      const float *xw, float wy, int count, float *b, float *g, float *r)
+{
+	const __m256 vwy = _mm256_set1_ps(wy);
+	const int *row0_i = reinterpret_cast<const int *>(row0);
+	const int *row1_i = reinterpret_cast<const int *>(row1);
+	const int *row0_next = reinterpret_cast<const int *>(row0 + 4);
+	const int *row1_next = reinterpret_cast<const int *>(row1 + 4);
+	int x = 0;
+	for (; x + 8 <= count; x += 8) {
+		// byte offsets of the left taps, gathered with a scale of 1
+		const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(xofs + x));
+		const __m256i p00 = _mm256_i32gather_epi32(row0_i, idx, 1);
+		const __m256i p01 = _mm256_i32gather_epi32(row0_next, idx, 1);
+		const __m256i p10 = _mm256_i32gather_epi32(row1_i, idx, 1);
+		const __m256i p11 = _mm256_i32gather_epi32(row1_next, idx, 1);
+		const __m256 wx = _mm256_loadu_ps(xw + x);
+
+		_mm256_storeu_ps(b + x, sample_avx2<0>(p00, p01, p10, p11, wx, vwy));
+		_mm256_storeu_ps(g + x, sample_avx2<8>(p00, p01, p10, p11, wx, vwy));
+		_mm256_storeu_ps(r + x, sample_avx2<16>(p00, p01, p10, p11, wx, vwy));
+	}
+	row_bgra_scalar(row0, row1, xofs, xw, wy, x, count, b, g, r);
+	return count;
+}
+
+bool cpu_has_sse41()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 19)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+bool cpu_has_avx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx) {
+		return false;
+	}
+	// the OS must save the YMM registers
+	if ((_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(PREPROCESS_NEON)
+
+template<int Shift> inline float32x4_t channel_neon(uint32x4_t pixels)
+{
+	// NEON immediate shifts start at 1
+	if constexpr (Shift > 0) {
+		pixels = vshrq_n_u32(pixels, Shift);
+	}
+	return vcvtq_f32_u32(vandq_u32(pixels, vdupq_n_u32(0xff)));
+}
+
+template<int Shift>
+inline float32x4_t sample_neon(uint32x4_t p00, uint32x4_t p01, uint32x4_t p10, uint32x4_t p11,
+			       float32x4_t wx, float32x4_t wy)
+{
+	const float32x4_t a = channel_neon<Shift>(p00);
+	const float32x4_t top = vaddq_f32(a, vmulq_f32(vsubq_f32(channel_neon<Shift>(p01), a), wx));
+	const float32x4_t c = channel_neon<Shift>(p10);
+	const float32x4_t bottom =
+		vaddq_f32(c, vmulq_f32(vsubq_f32(channel_neon<Shift>(p11), c), wx));
+	return vaddq_f32(top, vmulq_f32(vsubq_f32(bottom, top), wy));
+}
+
+inline uint32x4_t gather_neon(const uint8_t *row, const int *o)
+{
+	const uint32_t lanes[4] = {load_u32(row + o[0]), load_u32(row + o[1]),
+				   load_u32(row + o[2]), load_u32(row + o[3])};
+	return vld1q_u32(lanes);
+}
+
+int row_bgra_neon(const uint8_t *row0, const uint8_t *row1, const int *xofs, const float *xw,
+		  float wy, int count, float *b, float *g, float *r)
+{
+	const float32x4_t vwy = vdupq_n_f32(wy);
+	int x = 0;
+	for (; x + 4 <= count; x += 4) {
+		const int *o = xofs + x;
+		const uint32x4_t p00 = gather_neon(row0, o);
+		const uint32x4_t p01 = gather_neon(row0 + 4, o);
+		const uint32x4_t p10 = gather_neon(row1, o);
+		const uint32x4_t p11 = gather_neon(row1 + 4, o);
+		const float32x4_t wx = vld1q_f32(xw + x);
+
+		vst1q_f32(b + x, sample_neon<0>(p00, p01, p10, p11, wx, vwy));
+		vst1q_f32(g + x, sample_neon<8>(p00, p01, p10, p11, wx, vwy));
+		vst1q_f32(r + x, sample_neon<16>(p00, p01, p10, p11, wx, vwy));
+	}
+	row_bgra_scalar(row0, row1, xofs, xw, wy, x, count, b, g, r);
+	return count;
+}
+
+#endif
+
+int row_bgra_plain(const uint8_t *row0, const uint8_t *row1, const int *xofs, const float *xw,
+		   float wy, int count, float *b, float *g, float *r)
+{
+	row_bgra_scalar(row0, row1, xofs, xw, wy, 0, count, b, g, r);
+	return count;
+}
+
+struct RowKernel {
+	row_kernel_t fn;
+	const char *name;
+};
+
+// the kernels this CPU supports, fastest first, the plain one is always last
+std::vector<RowKernel> select_row_kernels()
+{
+	std::vector<RowKernel> kernels;
+#if defined(PREPROCESS_X86)
+	if (cpu_has_avx2()) {
+		kernels.push_back({row_bgra_avx2, "AVX2"});
+	}
+	if (cpu_has_sse41()) {
+		kernels.push_back({row_bgra_sse41, "SSE4.1"});
+	}
+#elif defined(PREPROCESS_NEON)
+	kernels.push_back({row_bgra_neon, "NEON"});
+#endif
+	kernels.push_back({row_bgra_plain, "scalar"});
+	return kernels;
+}
+
+const std::vector<RowKernel> &row_kernels()
+{
+	static const std::vector<RowKernel> kernels = select_row_kernels();
+	return kernels;
+}
+
+const RowKernel &row_kernel()
+{
+	return row_kernels().front();
+}
+
+// Bilinear taps of the last geometry, per thread. Every model and tile keeps its geometry from
+// frame to frame, so they are only computed again when a source or input size changes.
+struct TapTables {
+	int src_w = 0;
+	int src_h = 0;
+	int resized_w = 0;
+	int resized_h = 0;
+	// source byte offsets of the BGRA pixels and their weights
+	std::vector<int> xofs;
+	std::vector<float> xw;
+	std::vector<int> yofs;
+	std::vector<float> yw;
+};
+
+const TapTables &tap_tables(int src_w, int src_h, const LetterboxInfo &info)
+{
+	thread_local TapTables taps;
+	if (taps.src_w != src_w || taps.src_h != src_h || taps.resized_w != info.resized_w ||
+	    taps.resized_h != info.resized_h) {
+		taps.xofs.resize((size_t)info.resized_w);
+		taps.xw.resize((size_t)info.resized_w);
+		taps.yofs.resize((size_t)info.resized_h);
+		taps.yw.resize((size_t)info.resized_h);
+		compute_taps(src_w, info.resized_w, taps.xofs.data(), taps.xw.data());
+		compute_taps(src_h, info.resized_h, taps.yofs.data(), taps.yw.data());
+		for (int &o : taps.xofs) {
+			o *= 4;
+		}
+		taps.src_w = src_w;
+		taps.src_h = src_h;
+		taps.resized_w = info.resized_w;
+		taps.resized_h = info.resized_h;
+	}
+	return taps;
+}
+
+void letterbox_with_kernel(row_kernel_t kernel, const uint8_t *src, int src_w, int src_h,
+			   size_t src_stride, int src_channels, float *dst, int dst_w, int dst_h,
+			   bool nhwc, float pad_value)
+{
+	// the vectorized kernels handle the common case of a BGRA frame into an NCHW blob
+	if (src_channels != 4 || nhwc || src_w < 2 || src_h < 2) {
+		letterbox_to_blob_scalar(src, src_w, src_h, src_stride, src_channels, dst, dst_w,
+					 dst_h, nhwc, pad_value);
+		return;
+	}
+
+	const LetterboxInfo info = letterbox_info(src_w, src_h, dst_w, dst_h);
+	const size_t plane = (size_t)dst_w * (size_t)dst_h;
+	const TapTables &taps = tap_tables(src_w, src_h, info);
+
+	for (int y = 0; y < dst_h; ++y) {
+		float *b = dst + (size_t)y * (size_t)dst_w;
+		float *g = b + plane;
+		float *r = g + plane;
+		int x = 0;
+		if (y < info.resized_h) {
+			const uint8_t *row0 = src + (size_t)taps.yofs[(size_t)y] * src_stride;
+			const uint8_t *row1 = row0 + src_stride;
+			x = kernel(row0, row1, taps.xofs.data(), taps.xw.data(),
+				   taps.yw[(size_t)y], info.resized_w, b, g, r);
+		}
+		// letterbox padding on the right and at the bottom
+		std::fill(b + x, b + dst_w, pad_value);
+		std::fill(g + x, g + dst_w, pad_value);
+		std::fill(r + x, r + dst_w, pad_value);
+	}
+}
+
+} // namespace
+
+const char *letterbox_kernel_name()
+{
+	return row_kernel().name;
+}
+
+std::vector<const char *> letterbox_kernel_names()
+{
+	std::vector<const char *> names;
+	for (const RowKernel &kernel : row_kernels()) {
+		names.push_back(kernel.name);
+	}
+	return names;
+}
+
+void letterbox_to_blob_scalar(const uint8_t *src, int src_w, int src_h, size_t src_stride,
+			      int src_channels, float *dst, int dst_w, int dst_h, bool nhwc,
+			      float pad_value)
+{
+	const LetterboxInfo info = letterbox_info(src_w, src_h, dst_w, dst_h);
+	const size_t plane = (size_t)dst_w * (size_t)dst_h;
+	const double scale_x = (double)src_w / (double)info.resized_w;
+	const double scale_y = (double)src_h / (double)info.resized_h;
+
+	for (int y = 0; y < dst_h; ++y) {
+		for (int x = 0; x < dst_w; ++x) {
+			float out[3] = {pad_value, pad_value, pad_value};
+			if (x < info.resized_w && y < info.resized_h) {
+				// sample point in source pixel coordinates, clamped to the image
+				float fx = (float)(((double)x + 0.5) * scale_x - 0.5);
+				float fy = (float)(((double)y + 0.5) * scale_y - 0.5);
+				int sx = (int)std::floor(fx);
+				int sy = (int)std::floor(fy);
+				fx -= (float)sx;
+				fy -= (float)sy;
+				if (sx < 0) {
+					sx = 0;
+					fx = 0.0f;
+				}
+				if (sy < 0) {
+					sy = 0;
+					fy = 0.0f;
+				}
+				if (sx >= src_w - 1) {
+					sx = src_w - 1;
+					fx = 0.0f;
+				}
+				if (sy >= src_h - 1) {
+					sy = src_h - 1;
+					fy = 0.0f;
+				}
+				const int sx1 = std::min(sx + 1, src_w - 1);
+				const int sy1 = std::min(sy + 1, src_h - 1);
+				const uint8_t *row0 = src + (size_t)sy * src_stride;
+				const uint8_t *row1 = src + (size_t)sy1 * src_stride;
+				for (int c = 0; c < 3; ++c) {
+					const float p00 = row0[sx * src_channels + c];
+					const float p01 = row0[sx1 * src_channels + c];
+					const float p10 = row1[sx * src_channels + c];
+					const float p11 = row1[sx1 * src_channels + c];
+					out[c] = lerp(lerp(p00, p01, fx), lerp(p10, p11, fx), fy);
+				}
+			}
+			const size_t i = (size_t)y * (size_t)dst_w + (size_t)x;
+			for (int c = 0; c < 3; ++c) {
+				if (nhwc) {
+					dst[i * 3 + (size_t)c] = out[c];
+				} else {
+					dst[(size_t)c * plane + i] = out[c];
+				}
+			}
+		}
+	}
+}
+
+void letterbox_to_blob(const uint8_t *src, int src_w, int src_h, size_t src_stride,
+		       int src_channels, float *dst, int dst_w, int dst_h, bool nhwc,
+		       float pad_value)
+{
+	letterbox_with_kernel(row_kernel().fn, src, src_w, src_h, src_stride, src_channels, dst,
+			      dst_w, dst_h, nhwc, pad_value);
+}
+
+bool letterbox_to_blob_kernel(const char *kernel, const uint8_t *src, int src_w, int src_h,
+			      size_t src_stride, int src_channels, float *dst, int dst_w,
+			      int dst_h, bool nhwc, float pad_value)
+{
+	for (const RowKernel &candidate : row_kernels()) {
+		if (strcmp(candidate.name, kernel) == 0) {
+			letterbox_with_kernel(candidate.fn, src, src_w, src_h, src_stride,
+					      src_channels, dst, dst_w, dst_h, nhwc, pad_value);
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,68 @@
+#ifndef PREPROCESS_H
+#define PREPROCESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Geometry of an image fitted into a model input with letterbox padding
+ *
+ * The image is scaled by `scale` to `resized_w` x `resized_h` and placed in the top-left
+ * corner of the model input, the rest of the input is padding.
+ */
+struct LetterboxInfo {
+	float scale;
+	int resized_w;
+	int resized_h;
+};
+
+LetterboxInfo letterbox_info(int src_w, int src_h, int dst_w, int dst_h);
+
+/**
+ * @brief Fused letterbox resize and conversion to a float blob
+ *
+ * Reads an 8-bit BGR or BGRA image, resizes it with bilinear sampling into the top-left
+ * corner of a `dst_w` x `dst_h` model input, fills the rest with `pad_value` and writes the
+ * three color channels (in source order, alpha is dropped) as float planes (NCHW) or
+ * interleaved (NHWC) straight into `dst`. Uses the fastest SIMD kernel the CPU supports.
+ *
+ * @param src  Pointer to the first pixel, may point into a larger image (e.g. a crop)
+ * @param src_stride  Bytes between source rows
+ * @param src_channels  3 for BGR or 4 for BGRA
+ */
+void letterbox_to_blob(const uint8_t *src, int src_w, int src_h, size_t src_stride,
+		       int src_channels, float *dst, int dst_w, int dst_h, bool nhwc = false,
+		       float pad_value = 114.0f);
+
+/**
+ * @brief Scalar reference implementation of letterbox_to_blob
+ *
+ * Produces the same output as the SIMD kernels, used as a fallback and to check them.
+ */
+void letterbox_to_blob_scalar(const uint8_t *src, int src_w, int src_h, size_t src_stride,
+			      int src_channels, float *dst, int dst_w, int dst_h, bool nhwc = false,
+			      float pad_value = 114.0f);
+
+/**
+ * @brief Name of the kernel used by letterbox_to_blob on this CPU (e.g. "AVX2")
+ */
+const char *letterbox_kernel_name();
+
+/**
+ * @brief Names of every kernel this CPU supports, the one letterbox_to_blob uses first
+ */
+std::vector<const char *> letterbox_kernel_names();
+
+/**
+ * @brief letterbox_to_blob with the named kernel instead of the fastest one
+ *
+ * For checking and timing every kernel the CPU supports.
+ *
+ * @return false when the CPU does not support the kernel, `dst` is left alone
+ */
+bool letterbox_to_blob_kernel(const char *kernel, const uint8_t *src, int src_w, int src_h,
+			      size_t src_stride, int src_channels, float *dst, int dst_w,
+			      int dst_h, bool nhwc = false, float pad_value = 114.0f);
+
+#endif // PREPROCESS_H
@@ -0,0 +1,122 @@
+#include "tiling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ONNXRuntimeModel.h"
+
+// overlap (intersection over the smaller box) above which detections are merged
+static const float TILE_MERGE_THRESHOLD = 0.6f;
+// frames per model run, bounds the memory of the batched input
+static const size_t TILE_BATCH_SIZE = 8;
+
+static std::vector<int> tile_offsets(int length, int tile, float overlap)
+{
+	if (length <= tile) {
+		return {0};
+	}
+	const float stride = std::max((float)tile * (1.0f - overlap), 1.0f);
+	const int count = (int)std::ceil((float)(length - tile) / stride) + 1;
+	std::vector<int> offsets((size_t)count);
+	for (int i = 0; i < count; i++) {
+		offsets[(size_t)i] = (int)std::lround((double)i * (double)(length - tile) /
+						      (double)(count - 1));
+	}
+	return offsets;
+}
+
+std::vector<cv::Rect> tile_grid(const cv::Size &frame, const cv::Size &tile, float overlap)
+{
+	overlap = std::min(std::max(overlap, 0.0f), 0.9f);
+	const int tile_w = std::min(tile.width, frame.width);
+	const int tile_h = std::min(tile.height, frame.height);
+
+	std::vector<cv::Rect> tiles;
+	for (int y : tile_offsets(frame.height, tile_h, overlap)) {
+		for (int x : tile_offsets(frame.width, tile_w, overlap)) {
+			tiles.emplace_back(x, y, tile_w, tile_h);
+		}
+	}
+	return tiles;
+}
+
+void merge_detections(std::vector<Object> &objects, float threshold)
+{
+	std::sort(objects.begin(), objects.end(),
+		  [](const Object &a, const Object &b) { return a.prob > b.prob; });
+
+	std::vector<Object> kept;
+	for (const Object &obj : objects) {
+		bool keep = true;
+		for (const Object &other : kept) {
+			if (other.label != obj.label) {
+				continue;
+			}
+			const float inter_area = (obj.rect & other.rect).area();
+			const float smaller_area = std::min(obj.rect.area(), other.rect.area());
+			if (smaller_area > 0.0f && inter_area / smaller_area > threshold) {
+				keep = false;
+				break;
+			}
+		}
+		if (keep) {
+			kept.push_back(obj);
+		}
+	}
+
+	// number the merged objects like the decoder does
+	for (size_t i = 0; i < kept.size(); i++) {
+		kept[i].id = i + 1;
+	}
+	objects = kept;
+}
+
+std::vector<Object> tiled_inference(ONNXRuntimeModel &model, const cv::Mat &frame,
+				    float overlap, bool fullFramePass, const DetectionQuery &query)
+{
+	const std::vector<cv::Rect> tiles =
+		tile_grid(cv::Size(frame.cols, frame.rows), model.inputSize(), overlap);
+	if (tiles.size() == 1) {
+		// the frame fits the model input, nothing to slice
+		return model.inference(frame, query);
+	}
+
+	// the top-K applies to the merged detections, the tiles only get the class and area limits
+	DetectionQuery tileQuery = query;
+	tileQuery.topK = 0;
+
+	// the views share the frame data, the preprocessing reads them in place
+	std::vector<cv::Mat> views;
+	std::vector<cv::Point2f> origins;
+	for (const cv::Rect &tile : tiles) {
+		views.push_back(frame(tile));
+		origins.emplace_back((float)tile.x, (float)tile.y);
+	}
+	if (fullFramePass) {
+		views.push_back(frame);
+		origins.emplace_back(0.0f, 0.0f);
+	}
+
+	std::vector<Object> objects;
+	for (size_t start = 0; start < views.size(); start += TILE_BATCH_SIZE) {
+		const size_t end = std::min(start + TILE_BATCH_SIZE, views.size());
+		const std::vector<cv::Mat> batch(views.begin() + (std::ptrdiff_t)start,
+						 views.begin() + (std::ptrdiff_t)end);
+		std::vector<std::vector<Object>> results = model.inferenceBatch(batch, tileQuery);
+		for (size_t i = 0; i < results.size(); i++) {
+			const cv::Point2f &origin = origins[start + i];
+			for (Object &obj : results[i]) {
+				obj.rect.x += origin.x;
+				obj.rect.y += origin.y;
+				objects.push_back(obj);
+			}
+		}
+	}
+
+	merge_detections(objects, TILE_MERGE_THRESHOLD);
+	if (query.topK > 0 && objects.size() > query.topK) {
+		// the merged detections are in descending confidence order
+		objects.resize(query.topK);
+	}
+	return objects;
+}
@@ -0,0 +1,43 @@
+#ifndef TILING_H
+#define TILING_H
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+#include "types.hpp"
+
+class ONNXRuntimeModel;
+
+/**
+ * @brief Overlapping tiles of `tile` size covering a frame of `frame` size
+ *
+ * Tiles are spread evenly so that neighbours overlap by at least `overlap` (fraction of the
+ * tile size). A frame smaller than the tile along an axis gets a single tile of the frame
+ * size along that axis.
+ */
+std::vector<cv::Rect> tile_grid(const cv::Size &frame, const cv::Size &tile, float overlap);
+
+/**
+ * @brief Class-aware merge of overlapping detections
+ *
+ * Greedy suppression in descending confidence order, only between objects of the same label.
+ * The overlap is measured as intersection over the smaller box, so that an object cut at a
+ * tile seam is merged into the complete detection from the neighbouring tile.
+ */
+void merge_detections(std::vector<Object> &objects, float threshold);
+
+/**
+ * @brief Sliced inference for small objects on high resolution frames
+ *
+ * Runs the model on overlapping tiles of the frame at the native model resolution, and
+ * optionally on the whole (downscaled) frame to keep catching large objects, then merges the
+ * detections across the tiles. The tiles are batched when the model supports it.
+ *
+ * @return Detected objects in frame coordinates
+ */
+std::vector<Object> tiled_inference(ONNXRuntimeModel &model, const cv::Mat &frame,
+				    float overlap, bool fullFramePass,
+				    const DetectionQuery &query = DetectionQuery());
+
+#endif // TILING_H
@@ -2,7 +2,12 @@
 #define EDGEYOLO_TYPES_HPP
 
 #include <opencv2/core/types.hpp>
-#include <opencv2/video/tracking.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
 
 #ifdef _WIN32
 #define file_name_t std::wstring
@@ -16,7 +21,50 @@ struct Object {
 	float prob;
 	uint64_t id;
 	uint64_t unseenFrames;
-	cv::KalmanFilter kf;
+};
+// detections are copied between the model, the tracker and the render, keep them cheap
+static_assert(std::is_trivially_copyable<Object>::value, "Object must be trivially copyable");
+
+/**
+ * @brief Which detections a model run returns
+ *
+ * Applied by the decoders before the proposals are sorted and suppressed, so rejected
+ * candidates cost no NMS work. Areas are in frame pixels. The crop region needs no limit here,
+ * the frame is already cropped before the model runs.
+ */
+struct DetectionQuery {
+	// allowed class ids, empty for all classes
+	std::vector<int> classes;
+	// boxes of at most minArea or above maxArea are dropped, 0 for no limit
+	float minArea = 0.0f;
+	float maxArea = 0.0f;
+	// keep at most this many detections of the highest confidence, 0 for all
+	size_t topK = 0;
+
+	bool allowsClass(int label) const
+	{
+		return classes.empty() ||
+		       std::find(classes.begin(), classes.end(), label) != classes.end();
+	}
+
+	// whether a box passes the area limits
+	bool allowsBox(const cv::Rect_<float> &rect) const
+	{
+		const float area = rect.width * rect.height;
+		if ((minArea > 0.0f && area <= minArea) || (maxArea > 0.0f && area > maxArea)) {
+			return false;
+		}
+		return true;
+	}
+
+	// the query for boxes in a space scaled by `scale` from the frame, e.g. the model input
+	DetectionQuery scaled(float scale) const
+	{
+		DetectionQuery query = *this;
+		query.minArea *= scale * scale;
+		query.maxArea *= scale * scale;
+		return query;
+	}
 };
 
 struct GridAndStride {
@@ -7,7 +7,7 @@
 #include <opencv2/opencv.hpp>
 #include "types.hpp"
 
-static std::vector<std::string> read_class_labels_file(file_name_t file_name)
+inline std::vector<std::string> read_class_labels_file(file_name_t file_name)
 {
 	std::vector<std::string> class_names;
 	std::ifstream ifs(file_name);
@@ -52,7 +52,7 @@ const float color_list[80][3] = {
 	{0.714f, 0.714f, 0.714f}, {0.857f, 0.857f, 0.857f}, {0.000f, 0.447f, 0.741f},
 	{0.314f, 0.717f, 0.741f}, {0.50f, 0.5f, 0.0f}};
 
-static void draw_objects(cv::Mat bgr, const std::vector<Object> &objects,
+inline void draw_objects(cv::Mat bgr, const std::vector<Object> &objects,
 			 const std::vector<std::string> &class_names)
 {
 
@@ -0,0 +1,90 @@
+#ifndef KALMAN_BOX_FILTER_H
+#define KALMAN_BOX_FILTER_H
+
+#include <opencv2/core/types.hpp>
+
+#include <array>
+
+/**
+ * @brief Constant-velocity Kalman filter of a bounding box
+ *
+ * The state is [x, y, width, height] and their velocities. The transition, the measurement,
+ * the process noise and the measurement noise of this model never mix the four axes, so the
+ * 8x8 covariance is four independent 2x2 blocks (position, position-velocity, velocity) and
+ * predict and correct reduce to a few closed-form scalar updates per axis. Fixed size, no
+ * heap allocations, trivially copyable.
+ */
+class KalmanBoxFilter {
+public:
+	static constexpr int AXES = 4;
+
+	// Start at the box with zero velocity and zero covariance
+	void init(const cv::Rect_<float> &box)
+	{
+		const std::array<float, AXES> measurement = toAxes(box);
+		for (int i = 0; i < AXES; i++) {
+			this->pos_[i] = measurement[i];
+			this->vel_[i] = 0.0f;
+			this->covPP_[i] = 0.0f;
+			this->covPV_[i] = 0.0f;
+			this->covVV_[i] = 0.0f;
+		}
+	}
+
+	// Move the state one frame forward: x' = F x, P' = F P F^T + Q
+	cv::Rect_<float> predict()
+	{
+		for (int i = 0; i < AXES; i++) {
+			this->pos_[i] += this->vel_[i];
+			this->covPP_[i] += 2.0f * this->covPV_[i] + this->covVV_[i] +
+					   0.25f * PROCESS_NOISE;
+			this->covPV_[i] += this->covVV_[i] + 0.5f * PROCESS_NOISE;
+			this->covVV_[i] += PROCESS_NOISE;
+		}
+		return this->box();
+	}
+
+	// Correct the state with a measured box, returns the corrected box
+	cv::Rect_<float> correct(const cv::Rect_<float> &box)
+	{
+		const std::array<float, AXES> measurement = toAxes(box);
+		for (int i = 0; i < AXES; i++) {
+			// only the position is measured, the innovation covariance is a scalar
+			const float s = this->covPP_[i] + MEASUREMENT_NOISE[i];
+			const float gainP = this->covPP_[i] / s;
+			const float gainV = this->covPV_[i] / s;
+			const float innovation = measurement[i] - this->pos_[i];
+			this->pos_[i] += gainP * innovation;
+			this->vel_[i] += gainV * innovation;
+			// P' = (I - K H) P
+			this->covVV_[i] -= gainV * this->covPV_[i];
+			this->covPP_[i] -= gainP * this->covPP_[i];
+			this->covPV_[i] -= gainP * this->covPV_[i];
+		}
+		return this->box();
+	}
+
+	cv::Rect_<float> box() const
+	{
+		return cv::Rect_<float>(this->pos_[0], this->pos_[1], this->pos_[2], this->pos_[3]);
+	}
+
+private:
+	// process noise scale of the constant-velocity model, Q = q [[I/4, I/2], [I/2, I]]
+	static constexpr float PROCESS_NOISE = 1e-1f;
+	// measurement noise of x, y, width and height
+	static constexpr float MEASUREMENT_NOISE[AXES] = {4.0f, 4.0f, 10.0f, 10.0f};
+
+	static std::array<float, AXES> toAxes(const cv::Rect_<float> &box)
+	{
+		return {box.x, box.y, box.width, box.height};
+	}
+
+	std::array<float, AXES> pos_;
+	std::array<float, AXES> vel_;
+	std::array<float, AXES> covPP_;
+	std::array<float, AXES> covPV_;
+	std::array<float, AXES> covVV_;
+};
+
+#endif // KALMAN_BOX_FILTER_H
@@ -1,17 +1,11 @@
 #include "Sort.h"
 
-#include "sort/munkres-cpp/matrix_base.h"
-#include "sort/munkres-cpp/adapters/matrix_std_2d_vector.h"
-#include "sort/munkres-cpp/munkres.h"
+#include "lapjv.h"
 
 #include <cmath>
 #include <limits>
 #include <algorithm>
 
-#include "plugin-support.h"
-
-#include <obs.h>
-
 #define INF std::numeric_limits<float>::infinity()
 
 // Constructor
@@ -20,73 +14,14 @@ Sort::Sort(size_t maxUnseenFrames_) : nextTrackID(0), maxUnseenFrames(maxUnseenF
 // Destructor
 Sort::~Sort() {}
 
-// Initialize the Kalman filter for a new object
-void Sort::initializeKalmanFilter(cv::KalmanFilter &kf, const cv::Rect_<float> &bbox)
-{
-	// Linear motion model with dimension: [x, y, width, height, dx, dy, dwidth, dheight]
-	kf.init(8, 4, 0);
-
-	// State vector: [x, y, width, height, dx, dy, dwidth, dheight]
-	kf.statePre.at<float>(0) = bbox.x;
-	kf.statePre.at<float>(1) = bbox.y;
-	kf.statePre.at<float>(2) = bbox.width;
-	kf.statePre.at<float>(3) = bbox.height;
-
-	// Transition matrix
-	kf.transitionMatrix = (cv::Mat_<float>(8, 8) << 1, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0,
-			       0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0,
-			       0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0,
-			       0, 0, 1);
-
-	// Measurement matrix
-	kf.measurementMatrix = cv::Mat::zeros(4, 8, CV_32F);
-	for (int i = 0; i < 4; ++i) {
-		kf.measurementMatrix.at<float>(i, i) = 1;
-	}
-
-	// Process noise covariance matrix
-	const float q = 1e-1f;
-	kf.processNoiseCov = (cv::Mat_<float>(8, 8) << 0.25, 0, 0, 0, 0.5, 0, 0, 0, 0, 0.25, 0, 0,
-			      0, 0.5, 0, 0, 0, 0, 0.25, 0, 0, 0, 0.5, 0, 0, 0, 0, 0.25, 0, 0, 0,
-			      0.5, 0.5, 0, 0, 0, 1, 0, 0, 0, 0, 0.5, 0, 0, 0, 1, 0, 0, 0, 0, 0.5, 0,
-			      0, 0, 1, 0, 0, 0, 0, 0.5, 0, 0, 0, 1) *
-			     q;
-
-	// Measurement noise covariance matrix
-	kf.measurementNoiseCov =
-		(cv::Mat_<float>(4, 4) << 4, 0, 0, 0, 0, 4, 0, 0, 0, 0, 10, 0, 0, 0, 0, 10);
-
-	// Error covariance matrix
-	cv::setIdentity(kf.errorCovPost, cv::Scalar::all(1e3));
-
-	// Correct the state vector with the initial measurement
-	cv::Mat measurement(4, 1, CV_32F);
-	measurement.at<float>(0) = bbox.x;
-	measurement.at<float>(1) = bbox.y;
-	measurement.at<float>(2) = bbox.width;
-	measurement.at<float>(3) = bbox.height;
-	kf.correct(measurement);
-}
-
-// Predict the next state of the object
-cv::Rect_<float> Sort::predict(cv::KalmanFilter &kf)
-{
-	cv::Mat prediction = kf.predict();
-	return cv::Rect_<float>(prediction.at<float>(0), prediction.at<float>(1),
-				prediction.at<float>(2), prediction.at<float>(3));
-}
-
-// Update the Kalman filter with a new measurement
-cv::Rect_<float> Sort::updateKalmanFilter(cv::KalmanFilter &kf, const cv::Rect_<float> &bbox)
+// Start a new track for a detection
+void Sort::addTrack(const Object &detection)
 {
-	cv::Mat measurement(4, 1, CV_32F);
-	measurement.at<float>(0) = bbox.x;
-	measurement.at<float>(1) = bbox.y;
-	measurement.at<float>(2) = bbox.width;
-	measurement.at<float>(3) = bbox.height;
-	const auto corrected = kf.correct(measurement);
-	return cv::Rect_<float>(corrected.at<float>(0), corrected.at<float>(1),
-				corrected.at<float>(2), corrected.at<float>(3));
+	trackedObjects.push_back(detection);
+	trackedObjects.back().id = nextTrackID++;
+	trackedObjects.back().unseenFrames = 0;
+	filters.emplace_back();
+	filters.back().init(detection.rect);
 }
 
 // Compute the Intersection over Union (IoU) between two rectangles
@@ -97,117 +32,159 @@ float computeIoU(const cv::Rect_<float> &rect1, const cv::Rect_<float> &rect2)
 	return intersectionArea / unionArea;
 }
 
-// Update the tracking with detected objects
-std::vector<Object> Sort::update(const std::vector<Object> &detections)
+// Match the detections to the tracks that are not used yet and correct the matched tracks
+void Sort::associate(const std::vector<Object> &detections, float minIoU,
+		     std::vector<bool> &trackedObjectUsed, std::vector<bool> &detectionUsed)
 {
-	if (detections.empty()) {
-		std::vector<Object> newTrackedObjects;
+	// Only pairs that overlap can be matched, so the cost of 1 - IoU is kept for those alone
+	// and the assignment is solved per group of mutually overlapping tracks and detections
+	const size_t numDetections = detections.size();
+	const size_t numTracks = trackedObjects.size();
+	// Detections sorted by their left edge, so every track only visits the detections that
+	// can overlap it horizontally
+	detectionOrder.resize(numDetections);
+	float maxDetectionWidth = 0.0f;
+	for (size_t j = 0; j < numDetections; ++j) {
+		detectionOrder[j] = (int)j;
+		maxDetectionWidth = std::max(maxDetectionWidth, detections[j].rect.width);
+	}
+	std::sort(detectionOrder.begin(), detectionOrder.end(), [&detections](int a, int b) {
+		return detections[a].rect.x < detections[b].rect.x;
+	});
+
+	edges.clear();
+	for (size_t i = 0; i < numTracks; ++i) {
+		if (trackedObjectUsed[i]) {
+			continue;
+		}
+		const cv::Rect_<float> &track = trackedObjects[i].rect;
+		auto it = std::upper_bound(
+			detectionOrder.begin(), detectionOrder.end(), track.x - maxDetectionWidth,
+			[&detections](float x, int j) { return x < detections[j].rect.x; });
+		for (; it != detectionOrder.end(); ++it) {
+			const cv::Rect_<float> &detection = detections[*it].rect;
+			if (detection.x >= track.x + track.width) {
+				break;
+			}
+			if (track.x >= detection.x + detection.width ||
+			    detection.y >= track.y + track.height ||
+			    track.y >= detection.y + detection.height) {
+				continue;
+			}
+			const float iou = computeIoU(track, detection);
+			if (iou > minIoU) {
+				edges.push_back({(int)i, *it, 1.0f - iou});
+			}
+		}
+	}
+	const std::vector<int> assignment =
+		lapjv_sparse((int)numTracks, (int)numDetections, edges);
 
+	// Update Kalman filters with associated detections
+	detectionUsed.assign(numDetections, false);
+	for (size_t i = 0; i < numTracks; ++i) {
+		const int j = assignment[i];
+		if (j < 0) {
+			continue;
+		}
+		// update the tracked object with the new detection
+		trackedObjects[i].rect = filters[i].correct(detections[j].rect);
+		trackedObjects[i].unseenFrames = 0;
+		trackedObjects[i].label = detections[j].label;
+		trackedObjects[i].prob = detections[j].prob;
+		// mark the detection and the tracked object as used
+		detectionUsed[j] = true;
+		trackedObjectUsed[i] = true;
+	}
+}
+
+// Update the tracking with detected objects
+std::vector<Object> Sort::update(const std::vector<Object> &detections,
+				 const std::vector<Object> &lowDetections)
+{
+	if (detections.empty() && lowDetections.empty()) {
 		// No detections, predict the next state of the existing tracks and update unseen frames
+		size_t kept = 0;
 		for (size_t i = 0; i < trackedObjects.size(); ++i) {
-			trackedObjects[i].rect = predict(trackedObjects[i].kf);
+			trackedObjects[i].rect = filters[i].predict();
 			trackedObjects[i].unseenFrames++;
 
 			// Remove lost tracks
 			if (trackedObjects[i].unseenFrames < this->maxUnseenFrames) {
-				newTrackedObjects.push_back(trackedObjects[i]);
+				trackedObjects[kept] = trackedObjects[i];
+				filters[kept] = filters[i];
+				kept++;
 			}
 		}
-		trackedObjects = newTrackedObjects;
+		trackedObjects.resize(kept);
+		filters.resize(kept);
 		return trackedObjects;
 	}
 
 	if (trackedObjects.empty()) {
 		// No existing tracks, create new tracks for all detections
 		for (const auto &detection : detections) {
-			cv::KalmanFilter kf;
-			initializeKalmanFilter(kf, detection.rect);
-			trackedObjects.push_back(detection);
-			trackedObjects.back().kf = kf; // store the Kalman filter in the object
-			trackedObjects.back().id = nextTrackID++;
-			trackedObjects.back().unseenFrames = 0;
+			addTrack(detection);
 		}
 		return trackedObjects;
 	}
 
 	// Predict new locations of existing tracked objects
 	for (size_t i = 0; i < trackedObjects.size(); ++i) {
-		trackedObjects[i].rect = predict(trackedObjects[i].kf);
+		trackedObjects[i].rect = filters[i].predict();
 	}
 
-	// Build the cost matrix for the Hungarian algorithm
-	size_t numDetections = detections.size();
-	std::vector<std::vector<float>> costMatrix(trackedObjects.size(),
-						   std::vector<float>(numDetections, 0));
-
-	for (size_t i = 0; i < trackedObjects.size(); ++i) {
-		for (size_t j = 0; j < numDetections; ++j) {
-			const float iou = computeIoU(trackedObjects[i].rect, detections[j].rect);
-			costMatrix[i][j] = iou > 0.0f ? 1.0f - iou : 10.0f;
-		}
-	}
-
-	// Solve the assignment problem using the Hungarian algorithm
-	munkres_cpp::matrix_std_2d_vector costMatrixAdapter(costMatrix);
-	munkres_cpp::Munkres<float, munkres_cpp::matrix_std_2d_vector> solver(costMatrixAdapter);
-
-	// Update Kalman filters with associated detections
-	std::vector<bool> detectionUsed(numDetections, false);
+	// Match the confident detections first, any overlap will do
 	std::vector<bool> trackedObjectUsed(trackedObjects.size(), false);
-	for (size_t i = 0; i < trackedObjects.size(); ++i) {
-		for (size_t j = 0; j < numDetections; ++j) {
-			if (costMatrix[i][j] == 0) {
-				const float iou =
-					computeIoU(trackedObjects[i].rect, detections[j].rect);
-				if (iou == 0) {
-					// prevent matching detections without any overlap
-					continue;
-				}
-				// update the tracked object with the new detection
-				trackedObjects[i].rect = updateKalmanFilter(trackedObjects[i].kf,
-									    detections[j].rect);
-				trackedObjects[i].unseenFrames = 0;
-				trackedObjects[i].label = detections[j].label;
-				trackedObjects[i].prob = detections[j].prob;
-				// mark the detection and the tracked object as used
-				detectionUsed[j] = true;
-				trackedObjectUsed[i] = true;
-				break;
-			}
-		}
+	std::vector<bool> detectionUsed;
+	associate(detections, 0.0f, trackedObjectUsed, detectionUsed);
+
+	// The low-confidence detections can only keep the remaining tracks alive (ByteTrack),
+	// they are mostly occluded objects or false positives and need a closer overlap
+	if (!lowDetections.empty()) {
+		std::vector<bool> lowDetectionUsed;
+		associate(lowDetections, LOW_DETECTION_MIN_IOU, trackedObjectUsed,
+			  lowDetectionUsed);
 	}
 
 	// Create new tracks for unmatched detections
-	for (size_t j = 0; j < numDetections; ++j) {
+	for (size_t j = 0; j < detections.size(); ++j) {
 		if (!detectionUsed[j]) {
-			cv::KalmanFilter kf;
-			initializeKalmanFilter(kf, detections[j].rect);
-			trackedObjects.push_back(detections[j]);
-			trackedObjects.back().kf = kf; // store the Kalman filter in the object
-			trackedObjects.back().id = nextTrackID++;
-			trackedObjects.back().unseenFrames = 0;
+			addTrack(detections[j]);
 			// resize trackedObjectUsed to match the new size of trackedObjects
 			trackedObjectUsed.resize(trackedObjects.size(), true);
 		}
 	}
 
-	// Remove lost tracks
-	std::vector<Object> newTrackedObjects;
-	std::vector<int> newTrackIDs;
+	// Remove lost tracks, compacting the tracks and their filters in place
+	size_t kept = 0;
 	for (size_t i = 0; i < trackedObjects.size(); ++i) {
 		if (trackedObjectUsed[i] ||
 		    trackedObjects[i].unseenFrames < this->maxUnseenFrames) {
-			newTrackedObjects.push_back(trackedObjects[i]);
+			trackedObjects[kept] = trackedObjects[i];
+			filters[kept] = filters[i];
 			if (!trackedObjectUsed[i]) {
-				newTrackedObjects.back().unseenFrames++;
+				trackedObjects[kept].unseenFrames++;
 			}
+			kept++;
 		}
 	}
-	trackedObjects = newTrackedObjects;
+	trackedObjects.resize(kept);
+	filters.resize(kept);
 
 	return trackedObjects;
 }
 
+// Extrapolate the tracked objects one frame forward with their Kalman state. This is not a
+// missed detection, so the unseen frame count is left alone.
+std::vector<Object> Sort::predict()
+{
+	for (size_t i = 0; i < trackedObjects.size(); ++i) {
+		trackedObjects[i].rect = filters[i].predict();
+	}
+	return trackedObjects;
+}
+
 // Get the current tracked objects and their tracking id
 std::vector<Object> Sort::getTrackedObjects() const
 {
@@ -2,10 +2,11 @@
 #define SORT_H
 
 #include <opencv2/core.hpp>
-#include <opencv2/video/tracking.hpp>
 #include <vector>
 
 #include "ort-model/types.hpp"
+#include "KalmanBoxFilter.h"
+#include "lapjv.h"
 
 class Sort {
 public:
@@ -15,8 +16,13 @@ public:
 	// Destructor
 	~Sort();
 
-	// Update the tracking with detected objects
-	std::vector<Object> update(const std::vector<Object> &detections);
+	// Update the tracking with detected objects. The low-confidence detections, when given,
+	// only keep existing tracks alive and never start new ones.
+	std::vector<Object> update(const std::vector<Object> &detections,
+				   const std::vector<Object> &lowDetections = {});
+
+	// Extrapolate the tracked objects one frame forward, for frames without a model run
+	std::vector<Object> predict();
 
 	// Get the current tracked objects and their classes
 	std::vector<Object> getTrackedObjects() const;
@@ -31,14 +37,23 @@ public:
 	size_t getMaxUnseenFrames() const { return this->maxUnseenFrames; }
 
 private:
-	// Private methods for the Kalman filter and other internal workings
-	void initializeKalmanFilter(cv::KalmanFilter &kf, const cv::Rect_<float> &bbox);
-	cv::Rect_<float> predict(cv::KalmanFilter &kf);
-	cv::Rect_<float> updateKalmanFilter(cv::KalmanFilter &kf, const cv::Rect_<float> &bbox);
+	// IoU a low-confidence detection needs with a track to be matched to it
+	static constexpr float LOW_DETECTION_MIN_IOU = 0.5f;
+
+	// Start a new track for a detection
+	void addTrack(const Object &detection);
+
+	// Match the detections to the tracks that are not used yet and correct the matched tracks
+	void associate(const std::vector<Object> &detections, float minIoU,
+		       std::vector<bool> &trackedObjectUsed, std::vector<bool> &detectionUsed);
 
-	// Data members for tracking
+	// Data members for tracking, the Kalman filter of trackedObjects[i] is filters[i]
 	std::vector<Object> trackedObjects;
+	std::vector<KalmanBoxFilter> filters;
 	uint64_t nextTrackID;
+	// Scratch of the association, kept to reuse the allocations
+	std::vector<int> detectionOrder;
+	std::vector<AssignmentEdge> edges;
 	size_t maxUnseenFrames;
 };
 
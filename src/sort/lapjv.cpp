@@ -0,0 +1,260 @@
+#include "lapjv.h"
+
+#include <algorithm>
+
+void lapjv(const std::vector<double> &cost, int n, std::vector<int> &rowsol)
+{
+	rowsol.assign(n, -1);
+	if (n <= 0) {
+		return;
+	}
+	std::vector<int> colsol(n, -1);
+	// column prices, the row prices are implied by the assigned pairs having zero reduced cost
+	std::vector<double> v(n);
+
+	// Column reduction: price every column at its cheapest row, assign it if that row is free.
+	// The minima are collected row by row to walk the matrix in memory order.
+	std::vector<int> imin(n, 0);
+	std::copy(cost.begin(), cost.begin() + n, v.begin());
+	for (int i = 1; i < n; i++) {
+		const double *rowCost = cost.data() + (size_t)i * n;
+		for (int j = 0; j < n; j++) {
+			if (rowCost[j] < v[j]) {
+				v[j] = rowCost[j];
+				imin[j] = i;
+			}
+		}
+	}
+	for (int j = n - 1; j >= 0; j--) {
+		if (rowsol[imin[j]] < 0) {
+			rowsol[imin[j]] = j;
+			colsol[j] = imin[j];
+		}
+	}
+
+	// Augmentation: Dijkstra from every free row over the reduced costs until a free column
+	std::vector<double> d(n);
+	std::vector<int> pred(n);
+	// columns [0, low) are scanned, [low, up) are at the current minimum distance, [up, n)
+	// are still to be reached
+	std::vector<int> cols(n);
+	for (int freeRow = 0; freeRow < n; freeRow++) {
+		if (rowsol[freeRow] >= 0) {
+			continue;
+		}
+		const double *freeCost = cost.data() + (size_t)freeRow * n;
+		for (int j = 0; j < n; j++) {
+			d[j] = freeCost[j] - v[j];
+			pred[j] = freeRow;
+			cols[j] = j;
+		}
+
+		int low = 0;
+		int up = 0;
+		int last = 0;
+		int endOfPath = -1;
+		double min = 0.0;
+		while (endOfPath < 0) {
+			if (up == low) {
+				// collect the columns at the next minimum distance
+				last = low - 1;
+				min = d[cols[up++]];
+				for (int k = up; k < n; k++) {
+					const int j = cols[k];
+					const double h = d[j];
+					if (h <= min) {
+						if (h < min) {
+							up = low;
+							min = h;
+						}
+						cols[k] = cols[up];
+						cols[up++] = j;
+					}
+				}
+				for (int k = low; k < up; k++) {
+					if (colsol[cols[k]] < 0) {
+						endOfPath = cols[k];
+						break;
+					}
+				}
+			}
+			if (endOfPath >= 0) {
+				break;
+			}
+
+			// scan the row assigned to the next closest column
+			const int j1 = cols[low++];
+			const int i = colsol[j1];
+			const double *rowCost = cost.data() + (size_t)i * n;
+			const double h = rowCost[j1] - v[j1] - min;
+			for (int k = up; k < n; k++) {
+				const int j = cols[k];
+				const double dist = rowCost[j] - v[j] - h;
+				if (dist < d[j]) {
+					pred[j] = i;
+					if (dist == min) {
+						if (colsol[j] < 0) {
+							endOfPath = j;
+							break;
+						}
+						cols[k] = cols[up];
+						cols[up++] = j;
+					}
+					d[j] = dist;
+				}
+			}
+		}
+
+		// update the prices of the scanned columns
+		for (int k = 0; k <= last; k++) {
+			const int j = cols[k];
+			v[j] += d[j] - min;
+		}
+
+		// flip the assignments along the path
+		int i;
+		do {
+			i = pred[endOfPath];
+			colsol[endOfPath] = i;
+			std::swap(endOfPath, rowsol[i]);
+		} while (i != freeRow);
+	}
+}
+
+// Root of a node in the union-find forest, halving the path on the way
+static int findRoot(std::vector<int> &parent, int node)
+{
+	while (parent[node] != node) {
+		parent[node] = parent[parent[node]];
+		node = parent[node];
+	}
+	return node;
+}
+
+std::vector<int> lapjv_sparse(int rows, int cols, const std::vector<AssignmentEdge> &edges,
+			      bool maximizePairs)
+{
+	std::vector<int> assignment(std::max(rows, 0), -1);
+	if (rows <= 0 || cols <= 0 || edges.empty()) {
+		return assignment;
+	}
+
+	// Connected components of the bipartite graph, nodes are the rows then the columns
+	const int nodes = rows + cols;
+	std::vector<int> parent(nodes);
+	for (int i = 0; i < nodes; i++) {
+		parent[i] = i;
+	}
+	for (const AssignmentEdge &edge : edges) {
+		const int a = findRoot(parent, edge.row);
+		const int b = findRoot(parent, rows + edge.col);
+		if (a != b) {
+			parent[a] = b;
+		}
+	}
+
+	// Number the components that have edges and give every node its index in its component
+	std::vector<int> component(nodes, -1);
+	std::vector<int> localIndex(nodes, -1);
+	std::vector<int> componentRows;
+	std::vector<int> componentCols;
+	std::vector<int> componentEdges;
+	for (const AssignmentEdge &edge : edges) {
+		const int root = findRoot(parent, edge.row);
+		if (component[root] < 0) {
+			component[root] = (int)componentRows.size();
+			componentRows.push_back(0);
+			componentCols.push_back(0);
+			componentEdges.push_back(0);
+		}
+		componentEdges[component[root]]++;
+	}
+	for (int node = 0; node < nodes; node++) {
+		const int c = component[findRoot(parent, node)];
+		if (c < 0) {
+			continue;
+		}
+		if (node < rows) {
+			localIndex[node] = componentRows[c]++;
+		} else {
+			localIndex[node] = componentCols[c]++;
+		}
+	}
+
+	// Bucket the edges by component
+	const size_t numComponents = componentRows.size();
+	std::vector<size_t> edgeStart(numComponents + 1, 0);
+	for (size_t c = 0; c < numComponents; c++) {
+		edgeStart[c + 1] = edgeStart[c] + (size_t)componentEdges[c];
+	}
+	std::vector<const AssignmentEdge *> sortedEdges(edges.size());
+	std::vector<size_t> edgeFill(edgeStart.begin(), edgeStart.end() - 1);
+	for (const AssignmentEdge &edge : edges) {
+		sortedEdges[edgeFill[component[findRoot(parent, edge.row)]]++] = &edge;
+	}
+
+	// Rows in component order, to map the local solution back
+	std::vector<size_t> rowStart(numComponents + 1, 0);
+	for (size_t c = 0; c < numComponents; c++) {
+		rowStart[c + 1] = rowStart[c] + (size_t)componentRows[c];
+	}
+	std::vector<int> globalRow(rowStart.back());
+	for (int row = 0; row < rows; row++) {
+		const int c = component[findRoot(parent, row)];
+		if (c >= 0) {
+			globalRow[rowStart[c] + (size_t)localIndex[row]] = row;
+		}
+	}
+	std::vector<int> globalCol(cols);
+
+	std::vector<double> dense;
+	std::vector<int> rowsol;
+	for (size_t c = 0; c < numComponents; c++) {
+		const int numRows = componentRows[c];
+		const int numCols = componentCols[c];
+		const AssignmentEdge *const *first = sortedEdges.data() + edgeStart[c];
+		const size_t count = edgeStart[c + 1] - edgeStart[c];
+
+		if (count == 1) {
+			// a single edge, the common case of a track overlapping only its detection
+			if (maximizePairs || first[0]->cost < 0.0f) {
+				assignment[first[0]->row] = first[0]->col;
+			}
+			continue;
+		}
+
+		// Dense square problem of the component. When the pairs are maximized, pairs
+		// without an edge get a cost above any difference an extra assigned pair could make
+		// to the total. Otherwise they cost nothing, like leaving the row unassigned.
+		const int n = std::max(numRows, numCols);
+		double forbidden = 0.0;
+		if (maximizePairs) {
+			double minCost = first[0]->cost;
+			double maxCost = first[0]->cost;
+			for (size_t e = 0; e < count; e++) {
+				minCost = std::min(minCost, (double)first[e]->cost);
+				maxCost = std::max(maxCost, (double)first[e]->cost);
+			}
+			forbidden = maxCost + (double)n * (maxCost - minCost) + 1.0;
+		}
+		dense.assign((size_t)n * n, forbidden);
+		for (size_t e = 0; e < count; e++) {
+			const AssignmentEdge &edge = *first[e];
+			const int localCol = localIndex[rows + edge.col];
+			double &entry = dense[(size_t)localIndex[edge.row] * n + localCol];
+			entry = std::min(entry, (double)edge.cost);
+			globalCol[localCol] = edge.col;
+		}
+
+		lapjv(dense, n, rowsol);
+		for (int r = 0; r < numRows; r++) {
+			const int localCol = rowsol[r];
+			if (localCol < numCols && dense[(size_t)r * n + localCol] < forbidden) {
+				const int row = globalRow[rowStart[c] + (size_t)r];
+				assignment[row] = globalCol[localCol];
+			}
+		}
+	}
+
+	return assignment;
+}
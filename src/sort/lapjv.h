@@ -0,0 +1,43 @@
+#ifndef LAPJV_H
+#define LAPJV_H
+
+#include <vector>
+
+/**
+ * @brief A pair of a row and a column that may be assigned to each other, and its cost
+ */
+struct AssignmentEdge {
+	int row;
+	int col;
+	float cost;
+};
+
+/**
+ * @brief Minimum-cost assignment of a square cost matrix (Jonker-Volgenant)
+ *
+ * Column reduction gives the initial prices and a partial assignment, every free row is then
+ * assigned along a shortest augmenting path over the reduced costs.
+ *
+ * @param cost  n x n costs, row-major and contiguous
+ * @param rowsol  Receives the column assigned to every row
+ */
+void lapjv(const std::vector<double> &cost, int n, std::vector<int> &rowsol);
+
+/**
+ * @brief Minimum-cost assignment restricted to the given edges
+ *
+ * Rows and columns without an edge between them are never assigned to each other. The edges
+ * are split in connected components that are solved separately as small dense problems, so
+ * when every row only has edges to a few columns (tracks and the detections overlapping them)
+ * the cost follows the size of the largest component, not of the whole matrix.
+ *
+ * @param maximizePairs  Maximize the number of assigned pairs first, then minimize their total
+ *                       cost. Otherwise pairs are optional, only edges of negative cost are
+ *                       worth assigning and the total cost alone is minimized, which makes a
+ *                       maximum weight matching of the negated costs.
+ * @return  The column assigned to every row, -1 for rows left unassigned
+ */
+std::vector<int> lapjv_sparse(int rows, int cols, const std::vector<AssignmentEdge> &edges,
+			      bool maximizePairs = true);
+
+#endif // LAPJV_H
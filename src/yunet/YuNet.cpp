@@ -27,16 +27,16 @@ YuNetONNX::YuNetONNX(file_name_t path_to_model, int intra_op_num_threads, int ke
 	padH = (int((this->input_h_[0] - 1) / divisor) + 1) * divisor;
 }
 
-std::vector<Object> YuNetONNX::inference(const cv::Mat &frame)
+std::vector<Object> YuNetONNX::inference(const cv::Mat &frame, const DetectionQuery &query)
 {
 	ONNXRuntimeModel::inference(frame, 0);
 
-	// Postprocessing
-	std::vector<Object> objects = postProcess(this->output_tensor_);
-
 	const float scale = std::fminf((float)input_w_[0] / (float)frame.cols,
 				       (float)input_h_[0] / (float)frame.rows);
 
+	// Postprocessing, the faces are decoded in model input coordinates
+	std::vector<Object> objects = postProcess(this->output_tensor_, query.scaled(scale));
+
 	// adjust scale to original image
 	for (auto &obj : objects) {
 		obj.rect.x = obj.rect.x / scale;
@@ -49,9 +49,14 @@ std::vector<Object> YuNetONNX::inference(const cv::Mat &frame)
 }
 
 // Adapted from https://github.com/opencv/opencv/blob/98b8825031f19f47b1e33a9b9c062208f8d4acb5/modules/objdetect/src/face_detect.cpp#L161
-std::vector<Object> YuNetONNX::postProcess(const std::vector<Ort::Value> &result)
+std::vector<Object> YuNetONNX::postProcess(const std::vector<Ort::Value> &result,
+					    const DetectionQuery &query)
 {
 	std::vector<Object> faces;
+	if (!query.allowsClass(0)) {
+		// faces are not in the allowed classes
+		return faces;
+	}
 	for (size_t i = 0; i < this->strides.size(); ++i) {
 		const float stride = (float)strides[i];
 		int cols = int((float)this->padW / stride);
@@ -93,6 +98,9 @@ std::vector<Object> YuNetONNX::postProcess(const std::vector<Ort::Value> &result
 				const float y1 = cy - h / 2.f;
 
 				face.rect = cv::Rect2f(x1, y1, w, h);
+				if (!query.allowsBox(face.rect)) {
+					continue;
+				}
 				face.label = 0;
 
 				// TODO Get landmarks
@@ -106,15 +114,14 @@ std::vector<Object> YuNetONNX::postProcess(const std::vector<Ort::Value> &result
 		}
 	}
 
-	// run NMS
-	ONNXRuntimeModel::qsort_descent_inplace(faces);
-	std::vector<int> picked;
-	ONNXRuntimeModel::nms_sorted_bboxes(faces, picked, this->nms_thresh_);
-
-	// Keep topk
-	if ((size_t)this->keep_topk < picked.size()) {
-		picked.resize(this->keep_topk);
+	// run NMS, keep topk
+	NmsOptions options = this->nmsOptions();
+	options.maxDetections = (size_t)this->keep_topk;
+	if (query.topK > 0) {
+		options.maxDetections = std::min(options.maxDetections, query.topK);
 	}
+	std::vector<int> picked;
+	nms(faces, picked, options);
 
 	std::vector<Object> faces_nms;
 	for (size_t i = 0; i < picked.size(); ++i) {
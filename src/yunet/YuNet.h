@@ -21,7 +21,8 @@ public:
 		  int inter_op_num_threads = 1, const std::string &use_gpu_ = "", int device_id = 0,
 		  bool use_parallel = false, float nms_th = 0.45f, float conf_th = 0.3f);
 
-	std::vector<Object> inference(const cv::Mat &frame) override;
+	std::vector<Object> inference(const cv::Mat &frame,
+				      const DetectionQuery &query = DetectionQuery()) override;
 
 private:
 	std::tuple<std::vector<cv::Rect>, std::vector<std::array<cv::Point2f, 5>>,
@@ -29,7 +30,8 @@ private:
 	inference_internal(const cv::Mat &image);
 
 	cv::Mat preprocess(const cv::Mat &image);
-	std::vector<Object> postProcess(const std::vector<Ort::Value> &result);
+	std::vector<Object> postProcess(const std::vector<Ort::Value> &result,
+					const DetectionQuery &query);
 
 	struct Detections {
 		std::vector<cv::Rect> bboxes;
@@ -0,0 +1,248 @@
+// Golden check of the EdgeYOLO proposal decoder against the decoder it replaced
+// (AbcEdgeYOLO::generate_edgeyolo_proposals), on random output tensors with the row count of
+// the large model. The proposals must be bit-identical.
+//
+// With --bench also times both decoders.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "edgeyolo/decode.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what, int classes, float threshold)
+{
+	printf("%-4s %s (%d classes, threshold %.2f)\n", ok ? "ok" : "FAIL", what, classes,
+	       threshold);
+	if (!ok) {
+		failures++;
+	}
+}
+
+// the previous decoder
+static void reference_proposals(int num_classes_, const int num_array, const float *feat_ptr,
+				const float prob_threshold, std::vector<Object> &objects)
+{
+	for (int idx = 0; idx < num_array; ++idx) {
+		const int basic_pos = idx * (num_classes_ + 5);
+
+		float box_objectness = feat_ptr[basic_pos + 4];
+		int class_id = 0;
+		float max_class_score = 0.0;
+		for (int class_idx = 0; class_idx < num_classes_; ++class_idx) {
+			float box_cls_score = feat_ptr[basic_pos + 5 + class_idx];
+			float box_prob = box_objectness * box_cls_score;
+			if (box_prob > max_class_score) {
+				class_id = class_idx;
+				max_class_score = box_prob;
+			}
+		}
+		if (max_class_score > prob_threshold) {
+			float x_center = feat_ptr[basic_pos + 0];
+			float y_center = feat_ptr[basic_pos + 1];
+			float w = feat_ptr[basic_pos + 2];
+			float h = feat_ptr[basic_pos + 3];
+
+			Object obj;
+			obj.rect.x = x_center - w * 0.5f;
+			obj.rect.y = y_center - h * 0.5f;
+			obj.rect.width = w;
+			obj.rect.height = h;
+			obj.label = class_id;
+			obj.prob = max_class_score;
+			objects.push_back(obj);
+		}
+	}
+}
+
+static bool same_proposals(const std::vector<Object> &a, const std::vector<Object> &b)
+{
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].label != b[i].label || a[i].prob != b[i].prob ||
+		    a[i].rect.x != b[i].rect.x || a[i].rect.y != b[i].rect.y ||
+		    a[i].rect.width != b[i].rect.width || a[i].rect.height != b[i].rect.height) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// rows of cx, cy, w, h, objectness and the class scores, mostly low objectness like real
+// outputs, with exact ties between the first two classes on some rows
+static std::vector<float> make_output(int numArray, int numClasses, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> u(0.0f, 1.0f);
+	const size_t rowSize = (size_t)numClasses + 5;
+	std::vector<float> output((size_t)numArray * rowSize);
+	for (int i = 0; i < numArray; i++) {
+		float *row = &output[(size_t)i * rowSize];
+		row[0] = u(rng) * 1280.0f;
+		row[1] = u(rng) * 736.0f;
+		row[2] = u(rng) * 200.0f;
+		row[3] = u(rng) * 200.0f;
+		row[4] = u(rng) * u(rng) * u(rng);
+		for (int c = 0; c < numClasses; c++) {
+			row[5 + c] = u(rng) * u(rng);
+		}
+		if (i % 97 == 0 && numClasses > 1) {
+			row[6] = row[5];
+		}
+	}
+	return output;
+}
+
+static void check_argmax()
+{
+	// every length covers the SIMD body and the scalar tail, ties keep the first index
+	bool ok = true;
+	for (int count = 1; count <= 13; count++) {
+		for (int at = 0; at < count; at++) {
+			std::vector<float> scores((size_t)count, 0.25f);
+			scores[(size_t)at] = 0.75f;
+			if (at + 2 < count) {
+				scores[(size_t)at + 2] = 0.75f;
+			}
+			float best;
+			const int index = edgeyolo_cpp::argmax_scores(scores.data(), count, best);
+			ok = ok && index == at && best == 0.75f;
+		}
+	}
+	check(ok, "argmax first index on ties", 13, 0.0f);
+}
+
+// the previous filter by object category, after decoding
+static std::vector<Object> with_labels(const std::vector<Object> &objects,
+				       const std::vector<int> &labels)
+{
+	std::vector<Object> kept;
+	for (const Object &obj : objects) {
+		if (std::find(labels.begin(), labels.end(), obj.label) != labels.end()) {
+			kept.push_back(obj);
+		}
+	}
+	return kept;
+}
+
+static void check_allow_list_keeps_labels()
+{
+	// an anchor of a dog (0.9) that also scores as a cat (0.4), with only cats allowed: the
+	// box is a dog and must be dropped, not reported as a cat
+	const float row[] = {100.0f, 100.0f, 50.0f, 50.0f, 1.0f, 0.9f, 0.4f};
+	const uint8_t catsOnly[] = {0, 1};
+	std::vector<Object> proposals;
+	edgeyolo_cpp::generate_proposals(row, 1, 2, 0.3f, catsOnly, DetectionQuery(), proposals);
+	check(proposals.empty(), "allow-list drops boxes of other classes", 2, 0.3f);
+}
+
+static void check_decoder(int numClasses, std::mt19937 &rng)
+{
+	// 736x1280 input of the large model
+	const int numArray = 13923;
+	const std::vector<float> output = make_output(numArray, numClasses, rng);
+
+	for (float threshold : {0.0f, 0.05f, 0.3f, 0.5f}) {
+		std::vector<Object> expected;
+		std::vector<Object> proposals;
+		reference_proposals(numClasses, numArray, output.data(), threshold, expected);
+		edgeyolo_cpp::generate_proposals(output.data(), numArray, numClasses, threshold,
+						 nullptr, DetectionQuery(), proposals);
+		check(same_proposals(expected, proposals), "matches the previous decoder",
+		      numClasses, threshold);
+
+		// an allow-list equals the previous decoder followed by the category filter
+		if (numClasses > 2) {
+			const std::vector<int> labels = {0, 2};
+			std::vector<uint8_t> allowed((size_t)numClasses, 0);
+			for (int label : labels) {
+				allowed[(size_t)label] = 1;
+			}
+			edgeyolo_cpp::generate_proposals(output.data(), numArray, numClasses,
+							 threshold, allowed.data(),
+							 DetectionQuery(), proposals);
+			check(same_proposals(with_labels(expected, labels), proposals),
+			      "allow-list matches the category filter", numClasses, threshold);
+		}
+
+		// the area limits drop the same boxes as filtering the reference output
+		DetectionQuery query;
+		query.minArea = 40.0f * 40.0f;
+		query.maxArea = 150.0f * 150.0f;
+		expected.clear();
+		reference_proposals(numClasses, numArray, output.data(), threshold, expected);
+		std::vector<Object> filtered;
+		for (const Object &obj : expected) {
+			const float area = obj.rect.width * obj.rect.height;
+			if (area > query.minArea && area <= query.maxArea) {
+				filtered.push_back(obj);
+			}
+		}
+		edgeyolo_cpp::generate_proposals(output.data(), numArray, numClasses, threshold,
+						 nullptr, query, proposals);
+		check(same_proposals(filtered, proposals), "area limits", numClasses,
+		      threshold);
+	}
+}
+
+static double elapsed_us(std::chrono::steady_clock::time_point start, int reps)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+		       .count() /
+	       (double)reps;
+}
+
+static void bench(std::mt19937 &rng)
+{
+	const int numArray = 13923;
+	const int reps = 50;
+	printf("\n%8s %10s %10s %12s %12s\n", "classes", "threshold", "proposals", "before us",
+	       "decode us");
+	for (int numClasses : {1, 80}) {
+		const std::vector<float> output = make_output(numArray, numClasses, rng);
+		for (float threshold : {0.3f, 0.5f}) {
+			std::vector<Object> expected;
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < reps; r++) {
+				expected.clear();
+				reference_proposals(numClasses, numArray, output.data(), threshold,
+						    expected);
+			}
+			const double before = elapsed_us(start, reps);
+
+			std::vector<Object> proposals;
+			start = std::chrono::steady_clock::now();
+			for (int r = 0; r < reps; r++) {
+				edgeyolo_cpp::generate_proposals(output.data(), numArray,
+								 numClasses, threshold, nullptr,
+								 DetectionQuery(), proposals);
+			}
+			const double after = elapsed_us(start, reps);
+			printf("%8d %10.2f %10zu %12.1f %12.1f\n", numClasses, threshold,
+			       proposals.size(), before, after);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::mt19937 rng(7);
+	check_argmax();
+	check_allow_list_keeps_labels();
+	for (int numClasses : {1, 3, 4, 7, 80}) {
+		check_decoder(numClasses, rng);
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		bench(rng);
+	}
+
+	printf("%d failures\n", failures);
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,235 @@
+// Checks the assignment solvers against a brute force over every assignment of small random
+// problems with tied costs: lapjv on dense square matrices, lapjv_sparse with the most pairs
+// at the least cost and lapjv_sparse with optional pairs.
+//
+// With --bench also times lapjv_sparse against lapjv on the full matrix for tracker-like
+// problems, where every track only overlaps a few detections.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "sort/lapjv.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what, int problems)
+{
+	printf("%-4s %s (%d problems)\n", ok ? "ok" : "FAIL", what, problems);
+	if (!ok) {
+		failures++;
+	}
+}
+
+// the best assignment of the rows from `row` on: most pairs first, then least cost. Without
+// an edge the cost is NAN. With optionalPairs only the cost counts.
+struct BruteForce {
+	int rows;
+	int cols;
+	const std::vector<double> &costs;
+	bool optionalPairs;
+	std::vector<bool> used;
+	int bestPairs = -1;
+	double bestCost = 0.0;
+
+	BruteForce(int rows_, int cols_, const std::vector<double> &costs_, bool optionalPairs_)
+		: rows(rows_),
+		  cols(cols_),
+		  costs(costs_),
+		  optionalPairs(optionalPairs_),
+		  used((size_t)cols_, false)
+	{
+		search(0, 0, 0.0);
+	}
+
+	void search(int row, int pairs, double cost)
+	{
+		if (row == rows) {
+			const int counted = optionalPairs ? 0 : pairs;
+			const bool better = counted > bestPairs ||
+					    (counted == bestPairs && cost < bestCost - 1e-9);
+			if (better) {
+				bestPairs = counted;
+				bestCost = cost;
+			}
+			return;
+		}
+		search(row + 1, pairs, cost);
+		for (int col = 0; col < cols; col++) {
+			const double c = costs[(size_t)(row * cols + col)];
+			if (!used[(size_t)col] && !std::isnan(c)) {
+				used[(size_t)col] = true;
+				search(row + 1, pairs + 1, cost + c);
+				used[(size_t)col] = false;
+			}
+		}
+	}
+};
+
+// whether an assignment only uses edges and every column once, with its pairs and cost
+static bool valid_assignment(const std::vector<int> &assignment, int rows, int cols,
+			     const std::vector<double> &costs, int &pairs, double &cost)
+{
+	if (assignment.size() != (size_t)rows) {
+		return false;
+	}
+	std::vector<bool> used((size_t)cols, false);
+	pairs = 0;
+	cost = 0.0;
+	for (int row = 0; row < rows; row++) {
+		const int col = assignment[(size_t)row];
+		if (col < 0) {
+			continue;
+		}
+		if (col >= cols || used[(size_t)col] ||
+		    std::isnan(costs[(size_t)(row * cols + col)])) {
+			return false;
+		}
+		used[(size_t)col] = true;
+		pairs++;
+		cost += costs[(size_t)(row * cols + col)];
+	}
+	return true;
+}
+
+static void check_dense()
+{
+	std::mt19937 rng(5);
+	const int problems = 5000;
+	bool ok = true;
+	for (int t = 0; t < problems; t++) {
+		const int n = 1 + (int)(rng() % 7);
+		std::vector<double> costs((size_t)(n * n));
+		for (double &c : costs) {
+			// eighths, so that many assignments tie
+			c = (double)(rng() % 8) / 8.0;
+		}
+		std::vector<int> rowsol;
+		lapjv(costs, n, rowsol);
+		int pairs;
+		double cost;
+		const BruteForce best(n, n, costs, false);
+		ok = ok && valid_assignment(rowsol, n, n, costs, pairs, cost) && pairs == n &&
+		     std::fabs(cost - best.bestCost) < 1e-6;
+	}
+	check(ok, "lapjv matches brute force", problems);
+}
+
+static void check_sparse(bool maximizePairs)
+{
+	std::mt19937 rng(maximizePairs ? 7 : 3);
+	const int problems = 20000;
+	bool ok = true;
+	for (int t = 0; t < problems; t++) {
+		const int rows = 1 + (int)(rng() % 6);
+		const int cols = 1 + (int)(rng() % 6);
+		const int density = (int)(rng() % 4);
+		std::vector<double> costs((size_t)(rows * cols), NAN);
+		std::vector<AssignmentEdge> edges;
+		for (int row = 0; row < rows; row++) {
+			for (int col = 0; col < cols; col++) {
+				if ((int)(rng() % 4) > density) {
+					continue;
+				}
+				// optional pairs are only worth assigning at a negative cost
+				const float c = maximizePairs ? (float)(rng() % 8) / 8.0f
+							      : 2.0f - (float)(rng() % 10);
+				costs[(size_t)(row * cols + col)] = c;
+				edges.push_back({row, col, c});
+			}
+		}
+		std::shuffle(edges.begin(), edges.end(), rng);
+
+		const std::vector<int> assignment =
+			lapjv_sparse(rows, cols, edges, maximizePairs);
+		int pairs;
+		double cost;
+		const BruteForce best(rows, cols, costs, !maximizePairs);
+		ok = ok && valid_assignment(assignment, rows, cols, costs, pairs, cost) &&
+		     (!maximizePairs || pairs == best.bestPairs) &&
+		     std::fabs(cost - best.bestCost) < 1e-6;
+	}
+	check(ok,
+	      maximizePairs ? "lapjv_sparse most pairs at least cost matches brute force"
+			    : "lapjv_sparse optional pairs matches brute force",
+	      problems);
+
+	check(lapjv_sparse(0, 0, {}, maximizePairs).empty() &&
+		      lapjv_sparse(3, 2, {}, maximizePairs) == std::vector<int>(3, -1),
+	      "no rows or no edges", 2);
+}
+
+static double elapsed_us(std::chrono::steady_clock::time_point start, int reps)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+		       .count() /
+	       (double)reps;
+}
+
+// n tracks on a grid and n detections shifted by a few px, an edge of 1 - IoU per overlap
+static void bench()
+{
+	std::mt19937 rng(9);
+	std::uniform_real_distribution<float> shift(-8.0f, 8.0f);
+	printf("\n%6s %8s %8s %14s %14s\n", "n", "spacing", "edges", "dense us", "sparse us");
+	for (int n : {10, 100, 400}) {
+		for (float spacing : {60.0f, 30.0f}) {
+			const int side = (int)std::ceil(std::sqrt((double)n));
+			std::vector<float> dx((size_t)n);
+			std::vector<float> dy((size_t)n);
+			for (int i = 0; i < n; i++) {
+				dx[(size_t)i] = shift(rng);
+				dy[(size_t)i] = shift(rng);
+			}
+			std::vector<AssignmentEdge> edges;
+			std::vector<double> dense((size_t)(n * n), 1.0);
+			for (int i = 0; i < n; i++) {
+				for (int j = 0; j < n; j++) {
+					const float x = (float)(j % side - i % side) * spacing +
+							dx[(size_t)j];
+					const float y = (float)(j / side - i / side) * spacing +
+							dy[(size_t)j];
+					const float inter = std::max(0.0f, 40.0f - std::fabs(x)) *
+							    std::max(0.0f, 40.0f - std::fabs(y));
+					if (inter > 0.0f) {
+						const float iou = inter / (2.0f * 1600.0f - inter);
+						edges.push_back({i, j, 1.0f - iou});
+						dense[(size_t)(i * n + j)] = 1.0 - iou;
+					}
+				}
+			}
+
+			const int reps = n >= 400 ? 5 : 200;
+			std::vector<int> rowsol;
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < reps; r++) {
+				lapjv(dense, n, rowsol);
+			}
+			const double denseUs = elapsed_us(start, reps);
+			start = std::chrono::steady_clock::now();
+			for (int r = 0; r < reps; r++) {
+				rowsol = lapjv_sparse(n, n, edges);
+			}
+			printf("%6d %8.0f %8zu %14.1f %14.1f\n", n, spacing, edges.size(), denseUs,
+			       elapsed_us(start, reps));
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	check_dense();
+	check_sparse(true);
+	check_sparse(false);
+
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		bench();
+	}
+
+	printf("%d failures\n", failures);
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,292 @@
+// Checks the NMS module against the NMS it replaced (ONNXRuntimeModel::nms_sorted_bboxes), on
+// clustered proposals like a detector produces on a crowded scene. Both the dense path and the
+// grid path (from 2048 candidates) are covered.
+//
+// With --bench also times both implementations.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "nms/nms.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what, size_t n)
+{
+	printf("%-4s %s (n=%zu)\n", ok ? "ok" : "FAIL", what, n);
+	if (!ok) {
+		failures++;
+	}
+}
+
+// the previous implementation: quicksort by descending score, then every candidate is
+// compared with all the kept boxes
+static void reference_sort(std::vector<Object> &objects, int left, int right)
+{
+	int i = left;
+	int j = right;
+	float p = objects[(size_t)(left + right) / 2].prob;
+	while (i <= j) {
+		while (objects[(size_t)i].prob > p)
+			++i;
+		while (objects[(size_t)j].prob < p)
+			--j;
+		if (i <= j) {
+			std::swap(objects[(size_t)i], objects[(size_t)j]);
+			++i;
+			--j;
+		}
+	}
+	if (left < j)
+		reference_sort(objects, left, j);
+	if (i < right)
+		reference_sort(objects, i, right);
+}
+
+static void reference_nms_sorted_bboxes(const std::vector<Object> &objects,
+					std::vector<int> &picked, float nms_threshold)
+{
+	picked.clear();
+	const size_t n = objects.size();
+	std::vector<float> areas(n);
+	for (size_t i = 0; i < n; ++i) {
+		areas[i] = objects[i].rect.area();
+	}
+	for (size_t i = 0; i < n; ++i) {
+		int keep = 1;
+		for (size_t j = 0; j < picked.size(); ++j) {
+			const Object &b = objects[(size_t)picked[j]];
+			float inter_area = (objects[i].rect & b.rect).area();
+			float union_area = areas[i] + areas[(size_t)picked[j]] - inter_area;
+			if (inter_area / union_area > nms_threshold)
+				keep = 0;
+		}
+		if (keep)
+			picked.push_back((int)i);
+	}
+}
+
+// ids of the objects the reference keeps, in score order
+static std::vector<uint64_t> reference_nms(std::vector<Object> objects, float threshold)
+{
+	std::vector<uint64_t> kept;
+	if (objects.empty()) {
+		return kept;
+	}
+	reference_sort(objects, 0, (int)objects.size() - 1);
+	std::vector<int> picked;
+	reference_nms_sorted_bboxes(objects, picked, threshold);
+	for (int i : picked) {
+		kept.push_back(objects[(size_t)i].id);
+	}
+	return kept;
+}
+
+// Gaussian Soft-NMS written directly from the paper, ids and final scores of the kept boxes
+static std::vector<std::pair<uint64_t, float>>
+reference_soft_nms(std::vector<Object> objects, float sigma, float scoreThreshold)
+{
+	std::vector<std::pair<uint64_t, float>> kept;
+	while (!objects.empty()) {
+		auto best = std::max_element(objects.begin(), objects.end(),
+					     [](const Object &a, const Object &b) {
+						     return a.prob < b.prob;
+					     });
+		const Object top = *best;
+		objects.erase(best);
+		kept.push_back({top.id, top.prob});
+		std::vector<Object> rest;
+		for (Object &obj : objects) {
+			const float inter = (top.rect & obj.rect).area();
+			const float iou = inter / (top.rect.area() + obj.rect.area() - inter);
+			obj.prob *= std::exp(-(iou * iou) / sigma);
+			if (obj.prob >= scoreThreshold) {
+				rest.push_back(obj);
+			}
+		}
+		objects = rest;
+	}
+	return kept;
+}
+
+// clustered proposals with distinct scores, so that both sorts give the same order
+static std::vector<Object> make_proposals(size_t n, int classes, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> u(0.0f, 1.0f);
+	std::vector<float> scores(n);
+	for (size_t i = 0; i < n; i++) {
+		scores[i] = (float)(i + 1) / (float)(n + 1);
+	}
+	std::shuffle(scores.begin(), scores.end(), rng);
+
+	std::vector<Object> objects(n);
+	for (size_t i = 0; i < n; i++) {
+		const float x = std::floor(u(rng) * 40.0f) * 30.0f + u(rng) * 8.0f;
+		const float y = std::floor(u(rng) * 20.0f) * 30.0f + u(rng) * 8.0f;
+		objects[i].rect = cv::Rect_<float>(x, y, 20.0f + u(rng) * 30.0f,
+						   30.0f + u(rng) * 40.0f);
+		objects[i].prob = scores[i];
+		objects[i].label = (int)(u(rng) * (float)classes);
+		objects[i].id = i;
+		objects[i].unseenFrames = 0;
+	}
+	return objects;
+}
+
+static std::vector<uint64_t> run_nms(std::vector<Object> objects, const NmsOptions &options)
+{
+	std::vector<int> picked;
+	nms(objects, picked, options);
+	std::vector<uint64_t> kept;
+	for (int i : picked) {
+		kept.push_back(objects[(size_t)i].id);
+	}
+	return kept;
+}
+
+static void check_size(size_t n)
+{
+	const int classes = 3;
+	const std::vector<Object> objects = make_proposals(n, classes, (unsigned)n);
+	NmsOptions options;
+
+	// class-agnostic, the previous behaviour
+	const std::vector<uint64_t> expected = reference_nms(objects, options.iouThreshold);
+	check(run_nms(objects, options) == expected, "agnostic matches nms_sorted_bboxes", n);
+
+	// class-aware: the reference run on every class separately, merged by score
+	std::vector<uint64_t> expectedAware;
+	for (int c = 0; c < classes; c++) {
+		std::vector<Object> ofClass;
+		for (const Object &obj : objects) {
+			if (obj.label == c) {
+				ofClass.push_back(obj);
+			}
+		}
+		const std::vector<uint64_t> kept = reference_nms(ofClass, options.iouThreshold);
+		expectedAware.insert(expectedAware.end(), kept.begin(), kept.end());
+	}
+	std::sort(expectedAware.begin(), expectedAware.end(),
+		  [&objects](uint64_t a, uint64_t b) { return objects[a].prob > objects[b].prob; });
+	NmsOptions aware = options;
+	aware.classAware = true;
+	check(run_nms(objects, aware) == expectedAware, "class-aware matches per-class reference",
+	      n);
+
+	// top K: the reference on the K best candidates
+	NmsOptions topK = options;
+	topK.topK = n / 2 + 1;
+	std::vector<Object> best = objects;
+	std::sort(best.begin(), best.end(),
+		  [](const Object &a, const Object &b) { return a.prob > b.prob; });
+	best.resize(std::min(best.size(), topK.topK));
+	check(run_nms(objects, topK) == reference_nms(best, options.iouThreshold),
+	      "top K matches reference on the best K", n);
+
+	// max detections: the first boxes of the full result
+	NmsOptions limited = options;
+	limited.maxDetections = 5;
+	std::vector<uint64_t> expectedLimited = expected;
+	expectedLimited.resize(std::min(expectedLimited.size(), limited.maxDetections));
+	check(run_nms(objects, limited) == expectedLimited, "max detections stops early", n);
+}
+
+static void check_soft(size_t n)
+{
+	const std::vector<Object> objects = make_proposals(n, 1, (unsigned)n + 1);
+	NmsOptions options;
+	options.soft = true;
+	options.scoreThreshold = 0.3f;
+
+	std::vector<Object> work = objects;
+	std::vector<int> picked;
+	nms(work, picked, options);
+	const std::vector<std::pair<uint64_t, float>> expected =
+		reference_soft_nms(objects, options.softSigma, options.scoreThreshold);
+	bool same = picked.size() == expected.size();
+	for (size_t i = 0; same && i < picked.size(); i++) {
+		const Object &obj = work[(size_t)picked[i]];
+		same = obj.id == expected[i].first && std::fabs(obj.prob - expected[i].second) < 1e-5f;
+	}
+	check(same, "soft NMS matches reference", n);
+}
+
+// boxes of very different sizes span different numbers of grid cells, overlapping boxes must
+// still be compared
+static void check_grid_mixed_sizes()
+{
+	const size_t n = 4096;
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> u(0.0f, 1.0f);
+	std::vector<Object> objects = make_proposals(n, 1, 5);
+	for (size_t i = 0; i < n; i += 7) {
+		const float size = 200.0f + u(rng) * 600.0f;
+		objects[i].rect = cv::Rect_<float>(u(rng) * 1200.0f, u(rng) * 600.0f, size, size);
+	}
+	for (size_t i = 3; i < n; i += 11) {
+		objects[i].rect.width = 1.0f + u(rng);
+		objects[i].rect.height = 1.0f + u(rng);
+	}
+	check(run_nms(objects, NmsOptions()) == reference_nms(objects, NmsOptions().iouThreshold),
+	      "grid matches reference with mixed box sizes", n);
+}
+
+static double elapsed_us(std::chrono::steady_clock::time_point start, int reps)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+		       .count() /
+	       (double)reps;
+}
+
+static void bench()
+{
+	printf("\n%6s %8s %12s %12s %8s\n", "n", "kept", "before us", "nms us", "speedup");
+	for (size_t n : {100, 1000, 2000, 3000, 8000}) {
+		const std::vector<Object> objects = make_proposals(n, 3, (unsigned)n);
+		const int reps = std::max(3, (int)(2000000 / (n * n / 10 + 1)));
+		const NmsOptions options;
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<uint64_t> kept;
+		for (int r = 0; r < reps; r++) {
+			kept = reference_nms(objects, options.iouThreshold);
+		}
+		const double before = elapsed_us(start, reps);
+
+		std::vector<Object> work;
+		std::vector<int> picked;
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < reps; r++) {
+			work = objects;
+			nms(work, picked, options);
+		}
+		const double after = elapsed_us(start, reps);
+		printf("%6zu %8zu %12.1f %12.1f %7.1fx\n", n, picked.size(), before, after,
+		       before / after);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	check(run_nms({}, NmsOptions()).empty(), "no candidates", 0);
+	for (size_t n : {1, 3, 10, 100, 255, 1000, 2047, 2048, 3000, 8000}) {
+		check_size(n);
+	}
+	for (size_t n : {10, 100, 500}) {
+		check_soft(n);
+	}
+	check_grid_mixed_sizes();
+
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		bench();
+	}
+
+	printf("%d failures\n", failures);
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+// Checks every letterbox kernel the CPU supports against letterbox_to_blob_scalar on random
+// frames: odd sizes, 2x2 sources, upscaling and rows with padding after the pixels. The
+// fallbacks for BGR frames and NHWC blobs must match the scalar letterbox exactly.
+//
+// With --bench also times the scalar letterbox and every kernel on a 1080p frame.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "ort-model/preprocess.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what, const char *kernel)
+{
+	printf("%-4s %s (%s)\n", ok ? "ok" : "FAIL", what, kernel);
+	if (!ok) {
+		failures++;
+	}
+}
+
+// h random rows of stride bytes, the bytes after the pixels of a row are garbage too
+static std::vector<uint8_t> make_frame(int h, size_t stride, std::mt19937 &rng)
+{
+	std::vector<uint8_t> frame(stride * (size_t)h);
+	for (uint8_t &v : frame) {
+		v = (uint8_t)(rng() & 0xff);
+	}
+	return frame;
+}
+
+static float largest_difference(const std::vector<float> &a, const std::vector<float> &b)
+{
+	float largest = 0.0f;
+	for (size_t i = 0; i < a.size(); i++) {
+		largest = std::max(largest, std::fabs(a[i] - b[i]));
+	}
+	return largest;
+}
+
+struct Geometry {
+	const char *what;
+	int src_w;
+	int src_h;
+	int padding;
+	int dst_w;
+	int dst_h;
+};
+
+static void check_kernel(const char *kernel, std::mt19937 &rng)
+{
+	const Geometry geometries[] = {
+		{"odd sizes", 33, 17, 0, 64, 64},
+		{"odd sizes", 641, 359, 0, 640, 384},
+		{"odd input size", 1920, 1080, 0, 417, 243},
+		{"2x2 source", 2, 2, 0, 64, 64},
+		{"2x2 source", 2, 2, 0, 3, 5},
+		{"upscaling", 5, 3, 0, 64, 64},
+		{"upscaling", 320, 180, 0, 1280, 736},
+		{"padded rows", 101, 77, 12, 160, 160},
+		{"padded rows", 1280, 720, 256, 640, 640},
+	};
+	for (const Geometry &g : geometries) {
+		const size_t stride = (size_t)g.src_w * 4 + (size_t)g.padding;
+		const std::vector<uint8_t> frame = make_frame(g.src_h, stride, rng);
+		const size_t size = (size_t)g.dst_w * (size_t)g.dst_h * 3;
+		std::vector<float> expected(size);
+		letterbox_to_blob_scalar(frame.data(), g.src_w, g.src_h, stride, 4, expected.data(),
+					 g.dst_w, g.dst_h);
+		// the same kernel twice, the second time with the cached tap tables
+		bool ok = true;
+		for (int pass = 0; pass < 2; pass++) {
+			std::vector<float> blob(size, -1.0f);
+			ok = ok && letterbox_to_blob_kernel(kernel, frame.data(), g.src_w, g.src_h,
+							    stride, 4, blob.data(), g.dst_w,
+							    g.dst_h) &&
+			     largest_difference(expected, blob) < 1e-3f;
+		}
+		char what[128];
+		snprintf(what, sizeof(what), "%s %dx%d+%d into %dx%d", g.what, g.src_w, g.src_h,
+			 g.padding, g.dst_w, g.dst_h);
+		check(ok, what, kernel);
+	}
+
+	// the padding value fills the letterbox on the right and at the bottom
+	const std::vector<uint8_t> wide = make_frame(16, 64 * 4, rng);
+	std::vector<float> blob(64 * 64 * 3, -1.0f);
+	letterbox_to_blob_kernel(kernel, wide.data(), 64, 16, 64 * 4, 4, blob.data(), 64, 64,
+				 false, 0.5f);
+	check(std::all_of(blob.begin() + 64 * 16, blob.begin() + 64 * 64,
+			  [](float v) { return v == 0.5f; }),
+	      "pad value below the frame", kernel);
+
+	// BGR frames and NHWC blobs fall back to the scalar letterbox
+	for (int channels : {3, 4}) {
+		const bool nhwc = channels == 4;
+		const size_t stride = 97 * (size_t)channels + 3;
+		const std::vector<uint8_t> frame = make_frame(61, stride, rng);
+		std::vector<float> expected(128 * 96 * 3);
+		std::vector<float> fallback(expected.size(), -1.0f);
+		letterbox_to_blob_scalar(frame.data(), 97, 61, stride, channels, expected.data(),
+					 128, 96, nhwc);
+		letterbox_to_blob_kernel(kernel, frame.data(), 97, 61, stride, channels,
+					 fallback.data(), 128, 96, nhwc);
+		check(expected == fallback, nhwc ? "NHWC falls back" : "BGR falls back", kernel);
+	}
+}
+
+static double elapsed_us(std::chrono::steady_clock::time_point start, int reps)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+		       .count() /
+	       (double)reps;
+}
+
+static void bench(std::mt19937 &rng)
+{
+	const int reps = 50;
+	const size_t stride = 1920 * 4;
+	const std::vector<uint8_t> frame = make_frame(1080, stride, rng);
+	std::vector<float> blob(640 * 384 * 3);
+	printf("\n1920x1080 into 640x384\n%10s %12s\n", "kernel", "us");
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < reps; r++) {
+		letterbox_to_blob_scalar(frame.data(), 1920, 1080, stride, 4, blob.data(), 640,
+					 384);
+	}
+	printf("%10s %12.1f\n", "reference", elapsed_us(start, reps));
+	for (const char *kernel : letterbox_kernel_names()) {
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < reps; r++) {
+			letterbox_to_blob_kernel(kernel, frame.data(), 1920, 1080, stride, 4,
+						 blob.data(), 640, 384);
+		}
+		printf("%10s %12.1f\n", kernel, elapsed_us(start, reps));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::mt19937 rng(11);
+	printf("     letterbox_to_blob uses %s\n", letterbox_kernel_name());
+	for (const char *kernel : letterbox_kernel_names()) {
+		check_kernel(kernel, rng);
+	}
+	std::vector<float> blob(4 * 4 * 3);
+	check(!letterbox_to_blob_kernel("none", nullptr, 2, 2, 8, 4, blob.data(), 4, 4),
+	      "unknown kernels are refused", "none");
+
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		bench(rng);
+	}
+
+	printf("%d failures\n", failures);
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,303 @@
+// Checks the closed-form KalmanBoxFilter against a generic dense 8x8 Kalman filter of the same
+// constant-velocity model in double precision, and the track ids and lifetimes of Sort.
+//
+// With --bench also times both filters and Sort::update with 10 to 1000 tracks.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "sort/Sort.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+	if (!ok) {
+		failures++;
+	}
+}
+
+// the textbook filter: x' = F x, P' = F P F^T + Q, K = P H^T (H P H^T + R)^-1
+struct ReferenceKalman {
+	double x[8] = {0};
+	double P[8][8] = {{0}};
+	double F[8][8] = {{0}};
+	double Q[8][8] = {{0}};
+	double R[4] = {4.0, 4.0, 10.0, 10.0};
+
+	explicit ReferenceKalman(const cv::Rect_<float> &box)
+	{
+		// Q = q [[I/4, I/2], [I/2, I]] with q = 0.1
+		for (int i = 0; i < 8; i++) {
+			F[i][i] = 1.0;
+		}
+		for (int i = 0; i < 4; i++) {
+			F[i][i + 4] = 1.0;
+			Q[i][i] = 0.025;
+			Q[i][i + 4] = 0.05;
+			Q[i + 4][i] = 0.05;
+			Q[i + 4][i + 4] = 0.1;
+		}
+		x[0] = box.x;
+		x[1] = box.y;
+		x[2] = box.width;
+		x[3] = box.height;
+	}
+
+	void predict()
+	{
+		double nx[8] = {0};
+		double FP[8][8] = {{0}};
+		for (int i = 0; i < 8; i++) {
+			for (int k = 0; k < 8; k++) {
+				nx[i] += F[i][k] * x[k];
+				for (int j = 0; j < 8; j++) {
+					FP[i][j] += F[i][k] * P[k][j];
+				}
+			}
+		}
+		for (int i = 0; i < 8; i++) {
+			x[i] = nx[i];
+			for (int j = 0; j < 8; j++) {
+				P[i][j] = Q[i][j];
+				for (int k = 0; k < 8; k++) {
+					P[i][j] += FP[i][k] * F[j][k];
+				}
+			}
+		}
+	}
+
+	void correct(const cv::Rect_<float> &box)
+	{
+		const double z[4] = {box.x, box.y, box.width, box.height};
+		// [S | I] reduced to [I | S^-1] by Gauss-Jordan, S = H P H^T + R
+		double S[4][8] = {{0}};
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				S[i][j] = P[i][j] + (i == j ? R[i] : 0.0);
+			}
+			S[i][4 + i] = 1.0;
+		}
+		for (int c = 0; c < 4; c++) {
+			const double pivot = S[c][c];
+			for (int j = 0; j < 8; j++) {
+				S[c][j] /= pivot;
+			}
+			for (int r = 0; r < 4; r++) {
+				if (r != c) {
+					const double f = S[r][c];
+					for (int j = 0; j < 8; j++) {
+						S[r][j] -= f * S[c][j];
+					}
+				}
+			}
+		}
+		double K[8][4] = {{0}};
+		for (int i = 0; i < 8; i++) {
+			for (int j = 0; j < 4; j++) {
+				for (int k = 0; k < 4; k++) {
+					K[i][j] += P[i][k] * S[k][4 + j];
+				}
+			}
+		}
+		double innovation[4];
+		for (int i = 0; i < 4; i++) {
+			innovation[i] = z[i] - x[i];
+		}
+		double nP[8][8];
+		for (int i = 0; i < 8; i++) {
+			for (int j = 0; j < 4; j++) {
+				x[i] += K[i][j] * innovation[j];
+			}
+			for (int j = 0; j < 8; j++) {
+				nP[i][j] = P[i][j];
+				for (int k = 0; k < 4; k++) {
+					nP[i][j] -= K[i][k] * P[k][j];
+				}
+			}
+		}
+		memcpy(P, nP, sizeof(P));
+	}
+};
+
+// a box moving right and down with noise, of the given track
+static cv::Rect_<float> measurement(int track, int frame, std::mt19937 &rng)
+{
+	std::normal_distribution<float> noise(0.0f, 2.0f);
+	return cv::Rect_<float>(100.0f + (float)track + 2.0f * (float)frame + noise(rng),
+				50.0f + 0.5f * (float)frame + noise(rng), 40.0f + noise(rng),
+				80.0f + noise(rng));
+}
+
+static void check_kalman()
+{
+	std::mt19937 rng(1);
+	double maxError = 0.0;
+	for (int track = 0; track < 100; track++) {
+		const cv::Rect_<float> start(100.0f + (float)track, 50.0f, 40.0f, 80.0f);
+		KalmanBoxFilter filter;
+		filter.init(start);
+		ReferenceKalman reference(start);
+		for (int frame = 0; frame < 200; frame++) {
+			filter.predict();
+			reference.predict();
+			// every third frame is a miss
+			if (frame % 3 != 2) {
+				const cv::Rect_<float> box = measurement(track, frame, rng);
+				filter.correct(box);
+				reference.correct(box);
+			}
+			const cv::Rect_<float> a = filter.box();
+			maxError = std::max({maxError, std::fabs(a.x - reference.x[0]),
+					     std::fabs(a.y - reference.x[1]),
+					     std::fabs(a.width - reference.x[2]),
+					     std::fabs(a.height - reference.x[3])});
+		}
+	}
+	printf("     largest difference to the dense filter %.2e px\n", maxError);
+	check(maxError < 1e-2, "closed form matches the dense filter");
+}
+
+// n 40 px objects on a grid with the given spacing, all moving right by one px per frame
+static std::vector<Object> grid_detections(int n, int frame, float spacing, std::mt19937 &rng)
+{
+	std::normal_distribution<float> noise(0.0f, 0.2f);
+	const int side = (int)std::ceil(std::sqrt((double)n));
+	std::vector<Object> detections((size_t)n);
+	for (int i = 0; i < n; i++) {
+		Object &obj = detections[(size_t)i];
+		obj.rect = cv::Rect_<float>((float)(i % side) * spacing + (float)frame + noise(rng),
+					    (float)(i / side) * spacing, 40.0f, 40.0f);
+		obj.label = 0;
+		obj.prob = 0.9f;
+		obj.id = 0;
+		obj.unseenFrames = 0;
+	}
+	return detections;
+}
+
+static void check_tracks()
+{
+	std::mt19937 rng(2);
+	const int n = 100;
+	Sort sort(5);
+
+	bool stable = true;
+	std::vector<Object> tracks;
+	for (int frame = 0; frame < 50; frame++) {
+		const std::vector<Object> detections = grid_detections(n, frame, 60.0f, rng);
+		tracks = sort.update(detections);
+		stable = stable && tracks.size() == (size_t)n;
+		// the filter starts without velocity and lags a few px behind the first frames
+		for (size_t i = 0; stable && i < tracks.size(); i++) {
+			stable = tracks[i].id == i && tracks[i].unseenFrames == 0 &&
+				 std::fabs(tracks[i].rect.x - detections[i].rect.x) < 5.0f;
+		}
+	}
+	check(stable, "every object keeps its track id");
+
+	// the tracks coast on their velocity while unseen, then end
+	tracks = sort.predict();
+	const float coasted = tracks.empty() ? 0.0f : tracks[0].rect.x;
+	for (int frame = 0; frame < 4; frame++) {
+		tracks = sort.update({});
+	}
+	check(tracks.size() == (size_t)n && tracks[0].unseenFrames == 4 &&
+		      tracks[0].rect.x > coasted + 3.0f,
+	      "unseen tracks coast until the frame limit");
+	tracks = sort.update({});
+	check(tracks.empty(), "unseen tracks end at the frame limit");
+
+	// low-confidence detections keep a track alive but never start one
+	Sort byteTrack(5);
+	Object kept;
+	kept.rect = cv::Rect_<float>(0.0f, 0.0f, 40.0f, 40.0f);
+	kept.label = 0;
+	kept.prob = 0.9f;
+	kept.id = 0;
+	kept.unseenFrames = 0;
+	Object confident = kept;
+	confident.rect.x = 500.0f;
+	Object stray = kept;
+	stray.rect.x = 1000.0f;
+	byteTrack.update({kept});
+	for (int frame = 0; frame < 10; frame++) {
+		Object low = kept;
+		low.prob = 0.2f;
+		tracks = byteTrack.update({confident}, {low, stray});
+	}
+	check(tracks.size() == 2 && tracks[0].id == 0 && tracks[0].unseenFrames == 0 &&
+		      tracks[1].id == 1,
+	      "low-confidence detections only keep tracks alive");
+}
+
+static double elapsed_us(std::chrono::steady_clock::time_point start, int reps)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+		       .count() /
+	       (double)reps;
+}
+
+static void bench()
+{
+	std::mt19937 rng(3);
+	const int frames = 1000;
+	std::vector<cv::Rect_<float>> boxes;
+	for (int frame = 0; frame < frames; frame++) {
+		boxes.push_back(measurement(0, frame, rng));
+	}
+	ReferenceKalman reference(boxes[0]);
+	auto start = std::chrono::steady_clock::now();
+	for (const cv::Rect_<float> &box : boxes) {
+		reference.predict();
+		reference.correct(box);
+	}
+	const double dense = elapsed_us(start, frames);
+	KalmanBoxFilter filter;
+	filter.init(boxes[0]);
+	start = std::chrono::steady_clock::now();
+	for (const cv::Rect_<float> &box : boxes) {
+		filter.predict();
+		filter.correct(box);
+	}
+	const double closedForm = elapsed_us(start, frames);
+	printf("\npredict and correct: dense %.3f us, closed form %.3f us (x %.0f)\n", dense,
+	       closedForm, filter.box().x);
+
+	printf("\n%6s %8s %14s\n", "tracks", "spacing", "update us");
+	for (int n : {10, 100, 1000}) {
+		for (float spacing : {60.0f, 30.0f}) {
+			Sort sort(5);
+			const int reps = n >= 1000 ? 20 : 200;
+			sort.update(grid_detections(n, 0, spacing, rng));
+			std::vector<std::vector<Object>> detections;
+			for (int frame = 1; frame <= reps; frame++) {
+				detections.push_back(grid_detections(n, frame, spacing, rng));
+			}
+			start = std::chrono::steady_clock::now();
+			for (const std::vector<Object> &frame : detections) {
+				sort.update(frame);
+			}
+			printf("%6d %8.0f %14.1f\n", n, spacing, elapsed_us(start, reps));
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	check_kalman();
+	check_tracks();
+
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		bench();
+	}
+
+	printf("%d failures\n", failures);
+	return failures > 0 ? 1 : 0;
+}
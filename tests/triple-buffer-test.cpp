@@ -0,0 +1,123 @@
+// Checks the TripleBuffer handoff between the inference worker and the graphics thread: the
+// single-threaded semantics, then a producer and a consumer thread racing over a million values.
+// The consumer must see strictly increasing values that were never torn by the producer.
+//
+// Configure with -DTESTS_THREAD_SANITIZER=ON to run the race under ThreadSanitizer.
+
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "TripleBuffer.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+	if (!ok) {
+		failures++;
+	}
+}
+
+struct Value {
+	uint64_t seq = 0;
+	// a container like the detections of detect_output, every element holds seq
+	std::vector<uint64_t> data;
+};
+
+static void fill(Value &value, uint64_t seq)
+{
+	value.seq = seq;
+	value.data.assign(16 + seq % 16, seq);
+}
+
+static bool untorn(const Value &value)
+{
+	for (uint64_t v : value.data) {
+		if (v != value.seq) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void check_single_thread()
+{
+	TripleBuffer<Value> buffer;
+	check(!buffer.hasNew() && !buffer.update(), "nothing to pick up before a publish");
+
+	fill(buffer.writeBuffer(), 1);
+	check(buffer.publish(), "first publish was picked up");
+	check(&buffer.writeBuffer() != &buffer.readBuffer(),
+	      "producer and consumer own different buffers");
+	check(buffer.hasNew() && buffer.update() && buffer.readBuffer().seq == 1,
+	      "update picks up the published value");
+	check(!buffer.hasNew() && !buffer.update() && buffer.readBuffer().seq == 1,
+	      "read buffer stays until the next publish");
+
+	fill(buffer.writeBuffer(), 2);
+	buffer.publish();
+	fill(buffer.writeBuffer(), 3);
+	check(!buffer.publish(), "publish reports the value replaced before a pick up");
+	check(buffer.update() && buffer.readBuffer().seq == 3 && !buffer.update(),
+	      "update picks up only the latest value");
+
+	fill(buffer.writeBuffer(), 4);
+	check(&buffer.writeBuffer() != &buffer.readBuffer() && buffer.readBuffer().seq == 3,
+	      "filling the write buffer leaves the read buffer alone");
+}
+
+static void check_threads()
+{
+	const uint64_t count = 1000000;
+	TripleBuffer<Value> buffer;
+	uint64_t replaced = 0;
+
+	std::thread producer([&buffer, &replaced, count]() {
+		for (uint64_t seq = 1; seq <= count; seq++) {
+			fill(buffer.writeBuffer(), seq);
+			if (!buffer.publish()) {
+				replaced++;
+			}
+			// let the consumer run in between on a single core
+			if (seq % 64 == 0) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	uint64_t last = 0;
+	uint64_t received = 0;
+	bool ordered = true;
+	bool intact = true;
+	while (last < count) {
+		if (!buffer.update()) {
+			std::this_thread::yield();
+			continue;
+		}
+		const Value &value = buffer.readBuffer();
+		ordered = ordered && value.seq > last;
+		intact = intact && untorn(value);
+		last = value.seq;
+		received++;
+	}
+	producer.join();
+
+	printf("     received %llu of %llu values, %llu replaced before a pick up\n",
+	       (unsigned long long)received, (unsigned long long)count,
+	       (unsigned long long)replaced);
+	check(ordered, "consumer sees increasing values");
+	check(intact, "consumer never sees a value being written");
+	check(received + replaced == count, "every value is either received or replaced");
+}
+
+int main()
+{
+	check_single_thread();
+	check_threads();
+
+	printf("%d failures\n", failures);
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+#include "mot-io.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+// Split a line on commas and whitespace into numbers, false on anything else
+static bool parse_numbers(const std::string &line, std::vector<double> &values)
+{
+	values.clear();
+	const char *p = line.c_str();
+	while (*p != '\0') {
+		if (*p == ',' || *p == ' ' || *p == '\t' || *p == '\r') {
+			p++;
+			continue;
+		}
+		char *end = nullptr;
+		const double value = strtod(p, &end);
+		if (end == p) {
+			return false;
+		}
+		values.push_back(value);
+		p = end;
+	}
+	return true;
+}
+
+bool read_mot_file(const std::string &path, bool groundTruth, MotSequence &sequence,
+		   std::string &error)
+{
+	sequence.frames.clear();
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		error = "cannot open " + path;
+		return false;
+	}
+
+	std::string line;
+	std::vector<double> values;
+	for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+		if (line.empty() || line[0] == '#' || line == "\r") {
+			continue;
+		}
+		if (!parse_numbers(line, values) || values.size() < 6) {
+			error = path + ":" + std::to_string(lineNumber) + ": not a MOT line";
+			return false;
+		}
+		const int frame = (int)values[0];
+		if (frame < 1) {
+			error = path + ":" + std::to_string(lineNumber) + ": frames start at 1";
+			return false;
+		}
+
+		MotBox box;
+		box.id = (int)values[1];
+		box.rect = cv::Rect_<float>((float)values[2], (float)values[3], (float)values[4],
+					    (float)values[5]);
+		if (values.size() > 6) {
+			if (groundTruth) {
+				box.consider = values[6] != 0.0;
+			} else {
+				box.confidence = (float)values[6];
+			}
+		}
+		if (groundTruth && values.size() > 7) {
+			box.label = (int)values[7];
+		}
+
+		if ((size_t)frame > sequence.frames.size()) {
+			sequence.frames.resize((size_t)frame);
+		}
+		sequence.frames[(size_t)frame - 1].push_back(box);
+	}
+	return true;
+}
+
+bool write_mot_file(const std::string &path, const MotSequence &sequence)
+{
+	FILE *file = fopen(path.c_str(), "w");
+	if (file == nullptr) {
+		return false;
+	}
+	for (size_t f = 0; f < sequence.frames.size(); f++) {
+		for (const MotBox &box : sequence.frames[f]) {
+			fprintf(file, "%zu,%d,%.2f,%.2f,%.2f,%.2f,%.4f,-1,-1,-1\n", f + 1, box.id,
+				box.rect.x, box.rect.y, box.rect.width, box.rect.height,
+				box.confidence);
+		}
+	}
+	return fclose(file) == 0;
+}
+
+std::vector<Object> mot_to_objects(const std::vector<MotBox> &boxes)
+{
+	std::vector<Object> objects(boxes.size());
+	for (size_t i = 0; i < boxes.size(); i++) {
+		objects[i].rect = boxes[i].rect;
+		objects[i].label = boxes[i].label < 0 ? 0 : boxes[i].label;
+		objects[i].prob = boxes[i].confidence;
+		objects[i].id = 0;
+		objects[i].unseenFrames = 0;
+	}
+	return objects;
+}
+
+std::vector<MotBox> objects_to_mot(const std::vector<Object> &objects)
+{
+	std::vector<MotBox> boxes(objects.size());
+	for (size_t i = 0; i < objects.size(); i++) {
+		// the track ids start at 0, MOT ids at 1
+		boxes[i].id = (int)objects[i].id + 1;
+		boxes[i].rect = objects[i].rect;
+		boxes[i].confidence = objects[i].prob;
+		boxes[i].label = objects[i].label;
+	}
+	return boxes;
+}
@@ -0,0 +1,54 @@
+#ifndef MOT_IO_H
+#define MOT_IO_H
+
+#include <string>
+#include <vector>
+
+#include "ort-model/types.hpp"
+
+/**
+ * @brief A box of a MOT challenge text file
+ *
+ * Detection files have an id of -1, ground truth files carry the object id and may mark boxes
+ * that are not evaluated (occluders, static persons) with a zero `consider` flag.
+ */
+struct MotBox {
+	int id = -1;
+	cv::Rect_<float> rect;
+	float confidence = 1.0f;
+	int label = -1;
+	bool consider = true;
+};
+
+/**
+ * @brief The boxes of a sequence, frames[0] holds the boxes of frame 1
+ */
+struct MotSequence {
+	std::vector<std::vector<MotBox>> frames;
+};
+
+/**
+ * @brief Read a MOT challenge text file
+ *
+ * Lines are `frame, id, left, top, width, height, confidence[, class[, visibility]]` for
+ * ground truth and `frame, id, left, top, width, height, confidence, x, y, z` for detections.
+ * Frames are numbered from 1. Empty lines and lines starting with # are skipped.
+ *
+ * @param groundTruth  Read the 7th column as the consider flag and the 8th as the class
+ * @param error  Receives the reason when the file cannot be read
+ */
+bool read_mot_file(const std::string &path, bool groundTruth, MotSequence &sequence,
+		   std::string &error);
+
+/**
+ * @brief Write boxes in the MOT challenge detection and result format
+ */
+bool write_mot_file(const std::string &path, const MotSequence &sequence);
+
+/**
+ * @brief Convert between the MOT boxes and the detected objects of the plugin
+ */
+std::vector<Object> mot_to_objects(const std::vector<MotBox> &boxes);
+std::vector<MotBox> objects_to_mot(const std::vector<Object> &objects);
+
+#endif // MOT_IO_H
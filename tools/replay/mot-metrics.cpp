@@ -0,0 +1,190 @@
+#include "mot-metrics.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "sort/lapjv.h"
+
+static float box_iou(const cv::Rect_<float> &a, const cv::Rect_<float> &b)
+{
+	const float intersection = (a & b).area();
+	const float unionArea = a.area() + b.area() - intersection;
+	return unionArea > 0.0f ? intersection / unionArea : 0.0f;
+}
+
+// Minimum cost assignment of the pairs overlapping by at least the threshold
+static std::vector<int> match_boxes(const std::vector<MotBox> &rows,
+				    const std::vector<MotBox> &cols, float iouThreshold,
+				    const std::vector<bool> &rowTaken,
+				    const std::vector<bool> &colTaken)
+{
+	std::vector<AssignmentEdge> edges;
+	for (size_t i = 0; i < rows.size(); i++) {
+		if (rowTaken[i]) {
+			continue;
+		}
+		for (size_t j = 0; j < cols.size(); j++) {
+			if (colTaken[j]) {
+				continue;
+			}
+			const float iou = box_iou(rows[i].rect, cols[j].rect);
+			if (iou >= iouThreshold) {
+				edges.push_back({(int)i, (int)j, 1.0f - iou});
+			}
+		}
+	}
+	return lapjv_sparse((int)rows.size(), (int)cols.size(), edges);
+}
+
+MotMetrics evaluate_mot(const MotSequence &groundTruth, const MotSequence &tracks,
+			float iouThreshold)
+{
+	MotMetrics metrics;
+	const size_t numFrames = std::max(groundTruth.frames.size(), tracks.frames.size());
+	const std::vector<MotBox> empty;
+
+	// ground truth id to the track id of its last match, and of its match in the last frame
+	std::map<int, int> lastMatch;
+	std::map<int, int> previousMatch;
+	std::map<int, int> currentMatch;
+	// frames in which a ground truth id and a track id match, for the identity metrics
+	std::map<std::pair<int, int>, size_t> idOverlap;
+	double iouSum = 0.0;
+
+	std::vector<MotBox> gtBoxes;
+	std::vector<MotBox> trackBoxes;
+	for (size_t f = 0; f < numFrames; f++) {
+		const std::vector<MotBox> &allGt =
+			f < groundTruth.frames.size() ? groundTruth.frames[f] : empty;
+		const std::vector<MotBox> &allTracks =
+			f < tracks.frames.size() ? tracks.frames[f] : empty;
+
+		// drop the ignored ground truth and the track boxes matching it
+		gtBoxes.clear();
+		trackBoxes = allTracks;
+		if (std::any_of(allGt.begin(), allGt.end(),
+				[](const MotBox &box) { return !box.consider; })) {
+			const std::vector<int> ignoredMatch =
+				match_boxes(allGt, allTracks, iouThreshold,
+					    std::vector<bool>(allGt.size(), false),
+					    std::vector<bool>(allTracks.size(), false));
+			std::vector<bool> trackIgnored(allTracks.size(), false);
+			for (size_t i = 0; i < allGt.size(); i++) {
+				if (!allGt[i].consider && ignoredMatch[i] >= 0) {
+					trackIgnored[ignoredMatch[i]] = true;
+				}
+			}
+			trackBoxes.clear();
+			for (size_t j = 0; j < allTracks.size(); j++) {
+				if (!trackIgnored[j]) {
+					trackBoxes.push_back(allTracks[j]);
+				}
+			}
+		}
+		for (const MotBox &box : allGt) {
+			if (box.consider) {
+				gtBoxes.push_back(box);
+			}
+		}
+		metrics.groundTruthBoxes += gtBoxes.size();
+		metrics.trackBoxes += trackBoxes.size();
+
+		for (const MotBox &gt : gtBoxes) {
+			for (const MotBox &track : trackBoxes) {
+				if (box_iou(gt.rect, track.rect) >= iouThreshold) {
+					idOverlap[{gt.id, track.id}]++;
+				}
+			}
+		}
+
+		// keep the matches of the last frame that still overlap enough
+		std::vector<int> gtMatch(gtBoxes.size(), -1);
+		std::vector<bool> gtTaken(gtBoxes.size(), false);
+		std::vector<bool> trackTaken(trackBoxes.size(), false);
+		for (size_t i = 0; i < gtBoxes.size(); i++) {
+			auto previous = previousMatch.find(gtBoxes[i].id);
+			if (previous == previousMatch.end()) {
+				continue;
+			}
+			for (size_t j = 0; j < trackBoxes.size(); j++) {
+				if (!trackTaken[j] && trackBoxes[j].id == previous->second &&
+				    box_iou(gtBoxes[i].rect, trackBoxes[j].rect) >= iouThreshold) {
+					gtMatch[i] = (int)j;
+					gtTaken[i] = true;
+					trackTaken[j] = true;
+					break;
+				}
+			}
+		}
+		// and assign the rest
+		const std::vector<int> assignment =
+			match_boxes(gtBoxes, trackBoxes, iouThreshold, gtTaken, trackTaken);
+		for (size_t i = 0; i < gtBoxes.size(); i++) {
+			if (gtMatch[i] < 0) {
+				gtMatch[i] = assignment[i];
+			}
+		}
+
+		currentMatch.clear();
+		size_t frameMatches = 0;
+		for (size_t i = 0; i < gtBoxes.size(); i++) {
+			if (gtMatch[i] < 0) {
+				metrics.misses++;
+				continue;
+			}
+			const MotBox &track = trackBoxes[gtMatch[i]];
+			frameMatches++;
+			iouSum += box_iou(gtBoxes[i].rect, track.rect);
+			auto last = lastMatch.find(gtBoxes[i].id);
+			if (last != lastMatch.end() && last->second != track.id) {
+				metrics.idSwitches++;
+			}
+			lastMatch[gtBoxes[i].id] = track.id;
+			currentMatch[gtBoxes[i].id] = track.id;
+		}
+		metrics.matches += frameMatches;
+		metrics.falsePositives += trackBoxes.size() - frameMatches;
+		previousMatch.swap(currentMatch);
+	}
+
+	if (metrics.groundTruthBoxes > 0) {
+		metrics.mota = 1.0 - (double)(metrics.misses + metrics.falsePositives +
+					      metrics.idSwitches) /
+					     (double)metrics.groundTruthBoxes;
+	}
+	if (metrics.matches > 0) {
+		metrics.motp = iouSum / (double)metrics.matches;
+	}
+
+	// Identity metrics: the one-to-one id mapping with the most matching frames
+	std::map<int, int> gtIndex;
+	std::map<int, int> trackIndex;
+	std::vector<AssignmentEdge> edges;
+	for (const auto &overlap : idOverlap) {
+		const int gtId = overlap.first.first;
+		const int trackId = overlap.first.second;
+		const int row = gtIndex.emplace(gtId, (int)gtIndex.size()).first->second;
+		const int col = trackIndex.emplace(trackId, (int)trackIndex.size()).first->second;
+		edges.push_back({row, col, -(float)overlap.second});
+	}
+	const std::vector<int> idAssignment =
+		lapjv_sparse((int)gtIndex.size(), (int)trackIndex.size(), edges, false);
+	double idTruePositives = 0.0;
+	for (const AssignmentEdge &edge : edges) {
+		if (idAssignment[edge.row] == edge.col) {
+			idTruePositives -= edge.cost;
+		}
+	}
+	if (metrics.trackBoxes > 0) {
+		metrics.idp = idTruePositives / (double)metrics.trackBoxes;
+	}
+	if (metrics.groundTruthBoxes > 0) {
+		metrics.idr = idTruePositives / (double)metrics.groundTruthBoxes;
+	}
+	if (metrics.trackBoxes + metrics.groundTruthBoxes > 0) {
+		metrics.idf1 = 2.0 * idTruePositives /
+			       (double)(metrics.trackBoxes + metrics.groundTruthBoxes);
+	}
+	return metrics;
+}
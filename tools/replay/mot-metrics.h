@@ -0,0 +1,43 @@
+#ifndef MOT_METRICS_H
+#define MOT_METRICS_H
+
+#include <cstddef>
+
+#include "mot-io.h"
+
+/**
+ * @brief CLEAR MOT and identity metrics of a tracker output against ground truth
+ */
+struct MotMetrics {
+	size_t groundTruthBoxes = 0;
+	size_t trackBoxes = 0;
+	size_t matches = 0;
+	size_t misses = 0;
+	size_t falsePositives = 0;
+	size_t idSwitches = 0;
+	// 1 - (misses + false positives + ID switches) / ground truth boxes
+	double mota = 0.0;
+	// mean IoU of the matched boxes
+	double motp = 0.0;
+	// identity precision, recall and F1 of the best one-to-one ground truth to track mapping
+	double idp = 0.0;
+	double idr = 0.0;
+	double idf1 = 0.0;
+};
+
+/**
+ * @brief Evaluate tracks against ground truth like the MOT challenge
+ *
+ * A ground truth box and a track box match when their IoU reaches `iouThreshold`. Matches of
+ * the previous frame are kept while they still overlap enough, the other boxes of a frame are
+ * matched by a minimum cost assignment. A ground truth object matched to another track than
+ * the last time is an ID switch. IDF1 maps every ground truth id to at most one track id,
+ * maximizing the number of frames where the mapped boxes match.
+ *
+ * Ground truth boxes whose consider flag is off are dropped together with the track boxes
+ * matching them, so detecting them is neither rewarded nor penalized.
+ */
+MotMetrics evaluate_mot(const MotSequence &groundTruth, const MotSequence &tracks,
+			float iouThreshold);
+
+#endif // MOT_METRICS_H
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "obs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+char *obs_module_config_path(const char *file);
+void bfree(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
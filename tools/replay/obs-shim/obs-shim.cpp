@@ -0,0 +1,34 @@
+// Stand-ins for the libobs functions the model sources call, see obs.h
+
+#include "plugin-support.h"
+
+#include <obs-module.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+void obs_log(int log_level, const char *format, ...)
+{
+	// the replay output is the report, keep the informational messages out of it
+	if (log_level > LOG_WARNING) {
+		return;
+	}
+	va_list args;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	fputc('\n', stderr);
+}
+
+char *obs_module_config_path(const char *file)
+{
+	// no module config folder, so no optimized model cache
+	(void)file;
+	return nullptr;
+}
+
+void bfree(void *ptr)
+{
+	free(ptr);
+}
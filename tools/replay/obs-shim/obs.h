@@ -0,0 +1,10 @@
+#pragma once
+
+// The part of libobs the model sources use when they are built into the replay tool
+
+enum {
+	LOG_ERROR = 100,
+	LOG_WARNING = 200,
+	LOG_INFO = 300,
+	LOG_DEBUG = 400,
+};
@@ -0,0 +1,412 @@
+// Offline replay of the detection and tracking pipeline of the plugin, without libobs.
+//
+// Replays MOT challenge detection files, or runs a model over a folder of frames, through the
+// NMS and the tracker, and reports the throughput and latency of every stage and, given
+// ground truth, the MOTA, IDF1 and ID switches of the tracks.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mot-io.h"
+#include "mot-metrics.h"
+#include "nms/nms.h"
+#include "sort/Sort.h"
+
+#ifdef REPLAY_WITH_MODEL
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "edgeyolo/edgeyolo_onnxruntime.hpp"
+#include "yunet/YuNet.h"
+#endif
+
+struct ReplayOptions {
+	std::string detectionsPath;
+	std::string framesPath;
+	std::string modelPath;
+	std::string modelType = "edgeyolo";
+	int numClasses = 80;
+	int numThreads = 1;
+	std::string groundTruthPath;
+	std::string outputPath;
+	std::string tracker = "sort";
+	float confThreshold = 0.5f;
+	float lowConfThreshold = 0.1f;
+	float nmsThreshold = 0.45f;
+	int maxUnseenFrames = 10;
+	bool showUnseen = false;
+	float matchIoU = 0.5f;
+	int repeat = 1;
+	// the run fails when a metric against the ground truth is below these
+	double minMota = -std::numeric_limits<double>::infinity();
+	double minIdf1 = -std::numeric_limits<double>::infinity();
+};
+
+// Run times of a pipeline stage, one per frame
+struct StageTimes {
+	std::string name;
+	std::vector<double> us;
+};
+
+static void print_usage(const char *program)
+{
+	fprintf(stderr,
+		"Usage: %s (--detections det.txt | --frames dir --model model.onnx) [options]\n"
+		"\n"
+		"  --detections PATH    replay a MOT challenge detection file\n"
+		"  --frames DIR         run the model over the images of DIR, in name order\n"
+		"  --model PATH         ONNX model for --frames\n"
+		"  --model-type TYPE    edgeyolo (default) or yunet\n"
+		"  --num-classes N      classes of an EdgeYOLO model (80)\n"
+		"  --threads N          ONNX Runtime threads (1)\n"
+		"  --gt PATH            MOT challenge ground truth, reports MOTA and IDF1\n"
+		"  --output PATH        write the tracks in the MOT challenge format\n"
+		"  --tracker MODE       sort (default) or bytetrack\n"
+		"  --conf X             confidence threshold (0.5)\n"
+		"  --low-conf X         lowest confidence handed to ByteTrack (0.1)\n"
+		"  --nms X              IoU threshold of the NMS over the replayed detections,\n"
+		"                       0 skips the NMS (0.45)\n"
+		"  --max-unseen N       frames a track survives without detections (10)\n"
+		"  --show-unseen        also output the tracks that were not detected in a frame\n"
+		"  --match-iou X        IoU a track needs with the ground truth to match it (0.5)\n"
+		"  --repeat N           replay N times and time all of them (1)\n"
+		"  --min-mota X         exit with 3 when the MOTA is below X, needs --gt\n"
+		"  --min-idf1 X         exit with 3 when the IDF1 is below X, needs --gt\n",
+		program);
+}
+
+static bool parse_options(int argc, char **argv, ReplayOptions &options)
+{
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--show-unseen") {
+			options.showUnseen = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			fprintf(stderr, "Missing value of %s\n", arg.c_str());
+			return false;
+		}
+		const char *value = argv[++i];
+		if (arg == "--detections") {
+			options.detectionsPath = value;
+		} else if (arg == "--frames") {
+			options.framesPath = value;
+		} else if (arg == "--model") {
+			options.modelPath = value;
+		} else if (arg == "--model-type") {
+			options.modelType = value;
+		} else if (arg == "--num-classes") {
+			options.numClasses = atoi(value);
+		} else if (arg == "--threads") {
+			options.numThreads = atoi(value);
+		} else if (arg == "--gt") {
+			options.groundTruthPath = value;
+		} else if (arg == "--output") {
+			options.outputPath = value;
+		} else if (arg == "--tracker") {
+			options.tracker = value;
+		} else if (arg == "--conf") {
+			options.confThreshold = (float)atof(value);
+		} else if (arg == "--low-conf") {
+			options.lowConfThreshold = (float)atof(value);
+		} else if (arg == "--nms") {
+			options.nmsThreshold = (float)atof(value);
+		} else if (arg == "--max-unseen") {
+			options.maxUnseenFrames = atoi(value);
+		} else if (arg == "--match-iou") {
+			options.matchIoU = (float)atof(value);
+		} else if (arg == "--repeat") {
+			options.repeat = std::max(1, atoi(value));
+		} else if (arg == "--min-mota") {
+			options.minMota = atof(value);
+		} else if (arg == "--min-idf1") {
+			options.minIdf1 = atof(value);
+		} else {
+			fprintf(stderr, "Unknown option %s\n", arg.c_str());
+			return false;
+		}
+	}
+
+	if (options.detectionsPath.empty() == options.framesPath.empty()) {
+		fprintf(stderr, "Give either --detections or --frames\n");
+		return false;
+	}
+	if (!options.framesPath.empty() && options.modelPath.empty()) {
+		fprintf(stderr, "--frames needs --model\n");
+		return false;
+	}
+	const bool hasLimits = options.minMota > -std::numeric_limits<double>::infinity() ||
+			       options.minIdf1 > -std::numeric_limits<double>::infinity();
+	if (hasLimits && options.groundTruthPath.empty()) {
+		fprintf(stderr, "--min-mota and --min-idf1 need --gt\n");
+		return false;
+	}
+	if (options.tracker != "sort" && options.tracker != "bytetrack") {
+		fprintf(stderr, "Unknown tracker %s\n", options.tracker.c_str());
+		return false;
+	}
+	return true;
+}
+
+static double elapsed_us(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+		.count();
+}
+
+static double percentile(std::vector<double> sorted, double p)
+{
+	if (sorted.empty()) {
+		return 0.0;
+	}
+	std::sort(sorted.begin(), sorted.end());
+	const size_t index = (size_t)(p * (double)(sorted.size() - 1) + 0.5);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void print_stage(const StageTimes &stage)
+{
+	double total = 0.0;
+	for (double us : stage.us) {
+		total += us;
+	}
+	const double fps = total > 0.0 ? (double)stage.us.size() * 1e6 / total : 0.0;
+	printf("%-10s %12.1f %12.1f %12.1f %12.1f\n", stage.name.c_str(), fps,
+	       total / (double)std::max<size_t>(stage.us.size(), 1), percentile(stage.us, 0.5),
+	       percentile(stage.us, 0.99));
+}
+
+// Confident detections stay in objects, the others move to lowObjects, like the filter does
+static void split_confidence(std::vector<Object> &objects, std::vector<Object> &lowObjects,
+			     float confThreshold)
+{
+	auto low = std::stable_partition(
+		objects.begin(), objects.end(),
+		[confThreshold](const Object &obj) { return obj.prob > confThreshold; });
+	lowObjects.assign(low, objects.end());
+	objects.erase(low, objects.end());
+}
+
+// Tracked objects as MOT boxes, the undetected tracks only when asked for
+static std::vector<MotBox> output_tracks(const std::vector<Object> &tracks, bool showUnseen)
+{
+	std::vector<Object> shown;
+	for (const Object &track : tracks) {
+		if (showUnseen || track.unseenFrames == 0) {
+			shown.push_back(track);
+		}
+	}
+	return objects_to_mot(shown);
+}
+
+// The detections of one frame, from the replayed file or from the model
+using DetectStage = std::vector<Object> (*)(size_t frame, void *context);
+
+static MotSequence run_pipeline(const ReplayOptions &options, size_t numFrames,
+				const std::string &detectName, DetectStage detect, void *context,
+				std::vector<StageTimes> &stages)
+{
+	stages = {{detectName, {}}, {"track", {}}, {"total", {}}};
+	const bool byteTrack = options.tracker == "bytetrack";
+
+	MotSequence tracks;
+	for (int run = 0; run < options.repeat; run++) {
+		Sort tracker((size_t)options.maxUnseenFrames);
+		tracks.frames.assign(numFrames, {});
+		std::vector<Object> lowObjects;
+		for (size_t f = 0; f < numFrames; f++) {
+			const auto start = std::chrono::steady_clock::now();
+			std::vector<Object> objects = detect(f, context);
+			const double detectUs = elapsed_us(start);
+
+			const auto trackStart = std::chrono::steady_clock::now();
+			split_confidence(objects, lowObjects, options.confThreshold);
+			if (!byteTrack) {
+				lowObjects.clear();
+			}
+			const std::vector<Object> tracked = tracker.update(objects, lowObjects);
+			stages[1].us.push_back(elapsed_us(trackStart));
+			stages[0].us.push_back(detectUs);
+			stages[2].us.push_back(elapsed_us(start));
+
+			tracks.frames[f] = output_tracks(tracked, options.showUnseen);
+		}
+	}
+	return tracks;
+}
+
+struct ReplayContext {
+	const ReplayOptions *options;
+	const MotSequence *detections;
+	std::vector<int> picked;
+};
+
+static std::vector<Object> replay_detections(size_t frame, void *context)
+{
+	ReplayContext &replay = *(ReplayContext *)context;
+	std::vector<Object> objects = mot_to_objects(replay.detections->frames[frame]);
+	if (replay.options->nmsThreshold <= 0.0f) {
+		return objects;
+	}
+	NmsOptions nmsOptions;
+	nmsOptions.iouThreshold = replay.options->nmsThreshold;
+	nmsOptions.topK = 0;
+	nms(objects, replay.picked, nmsOptions);
+	std::vector<Object> kept;
+	kept.reserve(replay.picked.size());
+	for (int index : replay.picked) {
+		kept.push_back(objects[index]);
+	}
+	return kept;
+}
+
+#ifdef REPLAY_WITH_MODEL
+struct ModelContext {
+	std::unique_ptr<ONNXRuntimeModel> model;
+	std::vector<cv::Mat> frames;
+};
+
+static std::vector<Object> run_model(size_t frame, void *context)
+{
+	ModelContext &modelContext = *(ModelContext *)context;
+	return modelContext.model->inference(modelContext.frames[frame]);
+}
+
+static bool load_model(const ReplayOptions &options, ModelContext &context)
+{
+	std::vector<std::filesystem::path> paths;
+	std::error_code error;
+	for (const auto &entry : std::filesystem::directory_iterator(options.framesPath, error)) {
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		if (extension == ".jpg" || extension == ".jpeg" || extension == ".png" ||
+		    extension == ".bmp") {
+			paths.push_back(entry.path());
+		}
+	}
+	if (error || paths.empty()) {
+		fprintf(stderr, "No frames in %s\n", options.framesPath.c_str());
+		return false;
+	}
+	std::sort(paths.begin(), paths.end());
+
+	// decode all frames first, the file reads are not part of the pipeline
+	for (const std::filesystem::path &path : paths) {
+		const cv::Mat image = cv::imread(path.string());
+		if (image.empty()) {
+			fprintf(stderr, "Cannot read %s\n", path.string().c_str());
+			return false;
+		}
+		// the filter hands BGRA frames to the model
+		context.frames.emplace_back();
+		cv::cvtColor(image, context.frames.back(), cv::COLOR_BGR2BGRA);
+	}
+
+	const file_name_t modelPath = std::filesystem::path(options.modelPath).native();
+	const float confThreshold = options.tracker == "bytetrack"
+					    ? std::min(options.confThreshold,
+						       options.lowConfThreshold)
+					    : options.confThreshold;
+	if (options.modelType == "yunet") {
+		context.model = std::make_unique<yunet::YuNetONNX>(modelPath, options.numThreads,
+								   50, options.numThreads, "cpu",
+								   0, true, 0.45f, confThreshold);
+	} else {
+		context.model = std::make_unique<edgeyolo_cpp::EdgeYOLOONNXRuntime>(
+			modelPath, options.numThreads, options.numClasses, options.numThreads,
+			"cpu", 0, true, 0.45f, confThreshold);
+	}
+	// warm up, like the filter does before the first frame
+	context.model->inference(context.frames[0]);
+	return true;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+	ReplayOptions options;
+	if (!parse_options(argc, argv, options)) {
+		print_usage(argv[0]);
+		return 2;
+	}
+
+	std::string error;
+	MotSequence groundTruth;
+	if (!options.groundTruthPath.empty() &&
+	    !read_mot_file(options.groundTruthPath, true, groundTruth, error)) {
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	MotSequence tracks;
+	std::vector<StageTimes> stages;
+	size_t numFrames = 0;
+	if (!options.detectionsPath.empty()) {
+		MotSequence detections;
+		if (!read_mot_file(options.detectionsPath, false, detections, error)) {
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		// run over the ground truth frames without detections too
+		numFrames = std::max(detections.frames.size(), groundTruth.frames.size());
+		detections.frames.resize(numFrames);
+		ReplayContext context{&options, &detections, {}};
+		tracks = run_pipeline(options, numFrames, "nms", replay_detections, &context,
+				      stages);
+	} else {
+#ifdef REPLAY_WITH_MODEL
+		ModelContext context;
+		if (!load_model(options, context)) {
+			return 1;
+		}
+		numFrames = context.frames.size();
+		tracks = run_pipeline(options, numFrames, "inference", run_model, &context,
+				      stages);
+#else
+		fprintf(stderr, "Built without ONNX Runtime, set REPLAY_ONNXRUNTIME_DIR to run "
+				"models\n");
+		return 1;
+#endif
+	}
+
+	printf("frames: %zu x %d, tracker: %s\n", numFrames, options.repeat,
+	       options.tracker.c_str());
+	printf("%-10s %12s %12s %12s %12s\n", "stage", "frames/s", "mean us", "p50 us",
+	       "p99 us");
+	for (const StageTimes &stage : stages) {
+		print_stage(stage);
+	}
+
+	bool regressed = false;
+	if (!options.groundTruthPath.empty()) {
+		const MotMetrics metrics = evaluate_mot(groundTruth, tracks, options.matchIoU);
+		printf("MOTA %.3f  MOTP %.3f  IDF1 %.3f  IDP %.3f  IDR %.3f\n", metrics.mota,
+		       metrics.motp, metrics.idf1, metrics.idp, metrics.idr);
+		printf("ID switches %zu  misses %zu  false positives %zu  ground truth %zu\n",
+		       metrics.idSwitches, metrics.misses, metrics.falsePositives,
+		       metrics.groundTruthBoxes);
+		if (metrics.mota < options.minMota) {
+			fprintf(stderr, "MOTA %.3f is below %.3f\n", metrics.mota, options.minMota);
+			regressed = true;
+		}
+		if (metrics.idf1 < options.minIdf1) {
+			fprintf(stderr, "IDF1 %.3f is below %.3f\n", metrics.idf1, options.minIdf1);
+			regressed = true;
+		}
+	}
+
+	if (!options.outputPath.empty() && !write_mot_file(options.outputPath, tracks)) {
+		fprintf(stderr, "Cannot write %s\n", options.outputPath.c_str());
+		return 1;
+	}
+	return regressed ? 3 : 0;
+}